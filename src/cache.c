@@ -0,0 +1,581 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: cache.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:17:47 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Persistent cache of rasterized glyphs. Rasterizing the glyphs is the most
+ * expensive part of a build, but the bitmap of a glyph only depends on the
+ * font file, the character, the size, the dpi values and the load flags
+ * (see t_cache_key). Rebuilds with a new renderer or writer or a changed
+ * origin can reuse the glyphs of a previous run.
+ *
+ * The cache is a single file. It starts with a header and is followed by the
+ * records. Each record is the key, the metrics of the glyph and the bitmap,
+ * padded to 8 bytes:
+ *
+ *  ,--------------------------
+ *  | t_cache_header
+ *  | t_cache_record   (1)
+ *  | bitmap           (1)
+ *  | t_cache_record   (2)
+ *  | ...
+ *  `--------------------------
+ *
+ * The file is mapped on cache_open() and an index of all records is build.
+ * New glyphs are collected in memory and appended by cache_close(). Builds
+ * running at the same time may share the file. The records are appended
+ * under an exclusive flock() of the file. The format is not portable, since
+ * the records are written in the byte order of the host. A file of another
+ * version or FreeType release is dropped.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define __CACHE_C__
+#include "config.h"
+#include "fontgen.h"
+#include "cache.h"
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
+#ifdef HAVE_FLOCK
+#include <sys/file.h>
+#endif
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define CACHE_MAGIC "FGCACHE"
+#define CACHE_VERSION 1
+
+/* the release of FreeType the glyphs are rasterized with
+ */
+#define CACHE_FREETYPE ((FREETYPE_MAJOR<<16)|(FREETYPE_MINOR<<8)|FREETYPE_PATCH)
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+
+/* size of a bitmap inside the file. All records are aligned to 8 bytes.
+ */
+#define PADDED(n) (((n)+7)&~7)
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+
+typedef struct tagCACHE_HEADER
+{
+    char magic[8];			// CACHE_MAGIC
+    uint32_t version;			// CACHE_VERSION
+    uint32_t freetype;			// CACHE_FREETYPE
+} t_cache_header;
+
+/* One glyph inside the file. The bitmap of \c sz_buffer bytes follows.
+ */
+typedef struct tagCACHE_RECORD
+{
+    uint64_t font_hash;			// key...
+    int32_t character;
+    int32_t pt_size;
+    int32_t dpi;
+    int32_t hdpi;
+    int32_t load_flags;
+    int32_t width;			// metrics of the glyph (see t_glyph_matrix)
+    int32_t height;
+    int32_t pitch;
+    int32_t advance;
+    int32_t vert_advance;
+    int32_t top;
+    int32_t offset_x;
+    int32_t sz_buffer;			// size of the bitmap
+    int32_t reserved;			// keep the size a multiple of 8
+} t_cache_record;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static char cache_file[MAXPATH+1] = {""};
+static bool cache_active = false;
+
+/* The content of the file. Only the first \c valid_size bytes are complete
+ * records. If \c reset is set, the file is unusable and rewritten.
+ */
+static uint8_t *data = NULL;
+static size_t data_size = 0;
+static size_t valid_size = 0;
+static bool mapped = false;
+static bool reset = false;
+
+/* Open addressed hash table of the records of the file. The table is build
+ * by cache_open() and is read-only afterwards, so the lookups need no lock.
+ */
+static const t_cache_record **index_table = NULL;
+static size_t index_mask = 0;
+static int num_records = 0;
+
+/* The new records (including the bitmap) to append to the file.
+ */
+static pthread_mutex_t pending_lock = PTHREAD_MUTEX_INITIALIZER;
+static t_cache_record **pending = NULL;
+static int num_pending = 0;
+static int max_pending = 0;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool load_cache_file ( void );
+static bool build_index ( void );
+static size_t find_tail ( int fd, size_t *file_size );
+static uint64_t key_hash ( const t_cache_key *key );
+static bool same_key ( const t_cache_record *rec, const t_cache_key *key );
+static void release_cache ( void );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+/* Use the cache file \c filename. A missing or unusable file is not an error,
+ * it is created by cache_close().
+ */
+bool cache_open ( const char *filename )
+{
+    if ( !filename || !filename[0] )
+    {
+	fprintf(stderr,"error: cache_open: illegal parameters\n");
+	return false;
+    }
+    strncpy(cache_file,filename,MAXPATH);
+    cache_file[MAXPATH]='\0';
+    if ( !load_cache_file() || !build_index() )
+    {
+	release_cache();
+	return false;
+    }
+    cache_active = true;
+    if ( is_verbose() )
+	fprintf(stderr,"info: cache '%s' holds %d glyphs\n",cache_file,num_records);
+    return true;
+}
+
+/* Search the glyph described by \c key. If found, \c gm is filled with a copy
+ * of the glyph. The buffer is allocated like the ones of the rasterizer.
+ * \c offset_y is left 0.
+ */
+bool cache_lookup ( const t_cache_key *key, t_glyph_matrix *gm )
+{
+    const t_cache_record *rec;
+    size_t i;
+
+    if ( !cache_active || !index_table )
+	return false;
+    for ( i=key_hash(key)&index_mask; (rec=index_table[i])!=NULL; i=(i+1)&index_mask )
+    {
+	if ( same_key(rec,key) )
+	    break;
+    }
+    if ( !rec )
+	return false;
+    gm->buffer = NULL;
+    if ( rec->sz_buffer )
+    {
+	gm->buffer = malloc(rec->sz_buffer);
+	if ( !gm->buffer )
+	    return false;			// rasterize it again
+	memcpy(gm->buffer,rec+1,rec->sz_buffer);
+    }
+    gm->width = rec->width;
+    gm->height = rec->height;
+    gm->pitch = rec->pitch;
+    gm->advance = rec->advance;
+    gm->vert_advance = rec->vert_advance;
+    gm->top = rec->top;
+    gm->offset_x = rec->offset_x;
+    gm->offset_y = 0;
+    gm->sz_buffer = rec->sz_buffer;
+    return true;
+}
+
+/* Remember the rasterized glyph \c gm described by \c key. It is written by
+ * cache_close(). Since the cache is an optimization only, errors are ignored.
+ */
+void cache_store ( const t_cache_key *key, const t_glyph_matrix *gm )
+{
+    t_cache_record *rec;
+    t_cache_record **p;
+
+    if ( !cache_active )
+	return;
+    rec = calloc(1,sizeof(t_cache_record)+PADDED(gm->sz_buffer));
+    if ( !rec )
+	return;
+    rec->font_hash = key->font_hash;
+    rec->character = key->character;
+    rec->pt_size = key->pt_size;
+    rec->dpi = key->dpi;
+    rec->hdpi = key->hdpi;
+    rec->load_flags = key->load_flags;
+    rec->width = gm->width;
+    rec->height = gm->height;
+    rec->pitch = gm->pitch;
+    rec->advance = gm->advance;
+    rec->vert_advance = gm->vert_advance;
+    rec->top = gm->top;
+    rec->offset_x = gm->offset_x;
+    rec->sz_buffer = gm->sz_buffer;
+    if ( gm->sz_buffer )
+	memcpy(rec+1,gm->buffer,gm->sz_buffer);
+
+    pthread_mutex_lock(&pending_lock);
+    if ( num_pending >= max_pending )
+    {
+	p = realloc(pending,(max_pending?2*max_pending:256)*sizeof(t_cache_record*));
+	if ( !p )
+	{
+	    pthread_mutex_unlock(&pending_lock);
+	    free(rec);
+	    return;
+	}
+	pending = p;
+	max_pending = max_pending?2*max_pending:256;
+    }
+    pending[num_pending++] = rec;
+    pthread_mutex_unlock(&pending_lock);
+}
+
+/* Append the new glyphs to the cache file and release the cache. An unusable
+ * file is replaced. The records are written with a single write(), so a broken
+ * run leaves at most one incomplete tail, which is dropped by the next run.
+ *
+ * Another build may have appended its records since cache_open(). So the
+ * end of the complete records is searched again, while the file is locked.
+ */
+bool cache_close ( void )
+{
+    t_cache_header header;
+    uint8_t *buffer;
+    size_t file_size;
+    size_t size;
+    size_t pos;
+    size_t len;
+    size_t end;
+    bool result = true;
+    int fd;
+    int i;
+
+    if ( !cache_active )
+	return true;
+    if ( num_pending )
+    {
+	size = sizeof(t_cache_header);
+	for ( i=0; i<num_pending; i++ )
+	    size += sizeof(t_cache_record)+PADDED(pending[i]->sz_buffer);
+	buffer = malloc(size);
+	fd = buffer ? open(cache_file,O_RDWR|O_CREAT|O_APPEND,0644) : -1;
+	if ( fd < 0 )
+	{
+	    fprintf(stderr,"error: cache_close: unable to write '%s'\n",cache_file);
+	    free(buffer);
+	    release_cache();
+	    return false;
+	}
+	memset(&header,0,sizeof(header));
+	memcpy(header.magic,CACHE_MAGIC,sizeof(CACHE_MAGIC));
+	header.version = CACHE_VERSION;
+	header.freetype = CACHE_FREETYPE;
+	memcpy(buffer,&header,sizeof(header));
+	pos = sizeof(header);
+	for ( i=0; i<num_pending; i++ )
+	{
+	    len = sizeof(t_cache_record)+PADDED(pending[i]->sz_buffer);
+	    memcpy(buffer+pos,pending[i],len);
+	    pos += len;
+	}
+#ifdef HAVE_FLOCK
+	if ( flock(fd,LOCK_EX) != 0 )
+	    result = false;
+#endif
+	// drop an incomplete tail or rewrite an unusable file
+	end = find_tail(fd,&file_size);
+	if ( result && end<file_size && ftruncate(fd,end)!=0 )
+	    result = false;
+	// the header is only written into an empty file
+	pos = end ? sizeof(header) : 0;
+	if ( result && write(fd,buffer+pos,size-pos)!=(ssize_t)(size-pos) )
+	    result = false;
+	if ( close(fd) != 0 )		// releases the lock
+	    result = false;
+	free(buffer);
+	if ( !result )
+	    fprintf(stderr,"error: cache_close: unable to write '%s'\n",cache_file);
+	else if ( is_verbose() )
+	    fprintf(stderr,"info: added %d glyphs to cache '%s'\n",num_pending,cache_file);
+    }
+    release_cache();
+    return result;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Make the cache file available in memory and check the header. Like the
+ * font files, the cache is mapped read-only or read into a buffer if mmap()
+ * is not available.
+ */
+static bool load_cache_file ( void )
+{
+    const t_cache_header *header;
+    struct stat st;
+    ssize_t len;
+    int fd;
+
+    reset = true;
+    fd = open(cache_file,O_RDONLY);
+    if ( fd < 0 )
+	return true;			// created by cache_close()
+    if ( fstat(fd,&st)!=0 || (size_t)st.st_size<sizeof(t_cache_header) )
+    {
+	close(fd);
+	return true;
+    }
+    data_size = st.st_size;
+#ifdef HAVE_MMAP
+    data = mmap(NULL,data_size,PROT_READ,MAP_PRIVATE,fd,0);
+    if ( data != MAP_FAILED )
+	mapped = true;
+    else
+#endif
+    {
+	data = malloc(data_size);
+	if ( !data )
+	{
+	    fprintf(stderr,"error: load_cache_file: memory allocation failed\n");
+	    close(fd);
+	    return false;
+	}
+	len = read(fd,data,data_size);
+	if ( len<0 || (size_t)len!=data_size )
+	{
+	    fprintf(stderr,"error: load_cache_file: unable to read '%s'\n",cache_file);
+	    close(fd);
+	    return false;
+	}
+    }
+    close(fd);
+
+    header = (const t_cache_header*)data;
+    if ( memcmp(header->magic,CACHE_MAGIC,sizeof(CACHE_MAGIC))!=0 ||
+	 header->version!=CACHE_VERSION ||
+	 header->freetype!=CACHE_FREETYPE )
+    {
+	if ( is_verbose() )
+	    fprintf(stderr,"info: cache '%s' is outdated, drop it\n",cache_file);
+	return true;
+    }
+    reset = false;
+    return true;
+}
+
+/* Build the hash table of all complete records of the file.
+ */
+static bool build_index ( void )
+{
+    const t_cache_record *rec;
+    t_cache_key key;
+    size_t pos;
+    size_t len;
+    size_t size;
+    size_t i;
+
+    valid_size = sizeof(t_cache_header);
+    num_records = 0;
+    if ( reset )
+	return true;
+    for ( pos=valid_size; pos+sizeof(t_cache_record)<=data_size; pos+=len )
+    {
+	rec = (const t_cache_record*)(data+pos);
+	if ( rec->sz_buffer < 0 )
+	    break;
+	len = sizeof(t_cache_record)+PADDED((size_t)rec->sz_buffer);
+	if ( pos+len > data_size )
+	    break;
+	num_records++;
+    }
+    valid_size = pos;
+    if ( num_records == 0 )
+	return true;
+
+    for ( size=64; size<2*(size_t)num_records; size*=2 )
+	;
+    index_table = calloc(size,sizeof(t_cache_record*));
+    if ( !index_table )
+    {
+	fprintf(stderr,"error: build_index: memory allocation failed\n");
+	return false;
+    }
+    index_mask = size-1;
+    for ( pos=sizeof(t_cache_header); pos<valid_size; pos+=len )
+    {
+	rec = (const t_cache_record*)(data+pos);
+	len = sizeof(t_cache_record)+PADDED((size_t)rec->sz_buffer);
+	key.font_hash = rec->font_hash;
+	key.character = rec->character;
+	key.pt_size = rec->pt_size;
+	key.dpi = rec->dpi;
+	key.hdpi = rec->hdpi;
+	key.load_flags = rec->load_flags;
+	for ( i=key_hash(&key)&index_mask; index_table[i]; i=(i+1)&index_mask )
+	{
+	    if ( same_key(index_table[i],&key) )
+		break;			// keep the first one
+	}
+	if ( !index_table[i] )
+	    index_table[i] = rec;
+    }
+    return true;
+}
+
+/* Return the end of the complete records of the open cache file \c fd and
+ * its size in \c file_size. Records are only appended, so the ones up to
+ * \c valid_size are still complete, if the header is unchanged. 0 means
+ * the file has to be rewritten.
+ */
+static size_t find_tail ( int fd, size_t *file_size )
+{
+    t_cache_header header;
+    t_cache_record rec;
+    struct stat st;
+    size_t pos;
+    size_t len;
+
+    *file_size = 0;
+    if ( fstat(fd,&st) != 0 )
+	return 0;
+    *file_size = st.st_size;
+    if ( pread(fd,&header,sizeof(header),0)!=(ssize_t)sizeof(header) ||
+	 memcmp(header.magic,CACHE_MAGIC,sizeof(CACHE_MAGIC))!=0 ||
+	 header.version!=CACHE_VERSION ||
+	 header.freetype!=CACHE_FREETYPE )
+	return 0;
+    pos = (reset || valid_size>*file_size) ? sizeof(header) : valid_size;
+    while ( pos+sizeof(rec)<=*file_size && pread(fd,&rec,sizeof(rec),pos)==(ssize_t)sizeof(rec) )
+    {
+	if ( rec.sz_buffer < 0 )
+	    break;
+	len = sizeof(rec)+PADDED((size_t)rec.sz_buffer);
+	if ( pos+len > *file_size )
+	    break;
+	pos += len;
+    }
+    return pos;
+}
+
+static uint64_t key_hash ( const t_cache_key *key )
+{
+    uint64_t hash = key->font_hash;
+
+    hash = (hash ^ (uint32_t)key->character) * 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (uint32_t)key->pt_size) * 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (uint32_t)key->dpi) * 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (uint32_t)key->hdpi) * 0x9e3779b97f4a7c15ULL;
+    hash = (hash ^ (uint32_t)key->load_flags) * 0x9e3779b97f4a7c15ULL;
+    return hash ^ (hash>>32);
+}
+
+static bool same_key ( const t_cache_record *rec, const t_cache_key *key )
+{
+    return rec->font_hash==key->font_hash &&
+	   rec->character==key->character &&
+	   rec->pt_size==key->pt_size &&
+	   rec->dpi==key->dpi &&
+	   rec->hdpi==key->hdpi &&
+	   rec->load_flags==key->load_flags;
+}
+
+static void release_cache ( void )
+{
+    int i;
+
+    for ( i=0; i<num_pending; i++ )
+	free(pending[i]);
+    free(pending);
+    pending = NULL;
+    num_pending = max_pending = 0;
+    free(index_table);
+    index_table = NULL;
+    index_mask = 0;
+    num_records = 0;
+    if ( data )
+    {
+#ifdef HAVE_MMAP
+	if ( mapped )
+	    munmap(data,data_size);
+	else
+#endif
+	    free(data);
+    }
+    data = NULL;
+    data_size = valid_size = 0;
+    mapped = false;
+    cache_active = false;
+}
+
+//}}}
+
+/* ==[End of file]========================================================== */
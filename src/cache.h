@@ -0,0 +1,81 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: cache.h
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:17:47 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ *
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#ifndef __CACHE_H__
+#define __CACHE_H__ 1
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            TYPEDECLARATIONS                             |*/
+/*`========================================================================='*/
+//{{{
+
+/* Everything the bitmap of a rasterized glyph depends on.
+ */
+typedef struct tagCACHE_KEY
+{
+    uint64_t font_hash;		// hash of the content of the font file
+    int32_t character;		// character code
+    int32_t pt_size;		// size in points
+    int32_t dpi;		// vertical (or both) dpi
+    int32_t hdpi;		// horizontal dpi. 0 means "same as dpi"
+    int32_t load_flags;		// FreeType load flags used to rasterize
+} t_cache_key;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                     PROTOTYPES OF GLOBAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+bool cache_open ( const char *filename );
+bool cache_lookup ( const t_cache_key *key, t_glyph_matrix *gm );
+void cache_store ( const t_cache_key *key, const t_glyph_matrix *gm );
+bool cache_close ( void );
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+#endif
+/* ==[End of file]========================================================== */
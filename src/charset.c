@@ -0,0 +1,551 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: charset.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:21:48 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Sets of Unicode code points. A set is stored as sorted list of ranges, so
+ * a sparse set like the one of a localized UI stays small. The glyphs of a
+ * font are numbered in the order of the code points. The ranges are also the
+ * lookup table code point -> glyph index written by the writers.
+ *
+ * A set is specified as a comma separated list of code points and ranges.
+ * A code point is written as "U+XXXX" (hex) or as C number:
+ *
+ *  ,--------------------------
+ *  |U+0020-007E,U+00A0-017F,U+2190-U+21FF,0x20AC,169
+ *  `--------------------------
+ *
+ * A set can also be collected from UTF-8 text files, like the translation
+ * catalogs of an application. Only the code points used by the texts are
+ * added. Control characters and the byte order mark are ignored.
+ *
+ * The last glyph of a font is not rendered. With --from and --to it is the
+ * code point \c to, which is only the end marker. A set specified by code
+ * points or text files gets a spare glyph without a code point instead, so
+ * all requested code points are rendered (see charset_add_spare). The tables
+ * of the writers leave the end marker out (see charset_used_ranges).
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#define __CHARSET_C__
+#include "fontgen.h"
+#include "charset.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool parse_code ( const char *str, char **end, int *code, bool *hex );
+static bool read_text_file ( const char *filename, uint8_t **text, size_t *size );
+static int decode_utf8 ( const uint8_t *p, size_t len, int *code );
+static void update_index ( t_char_set *set );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+void charset_init ( t_char_set *set )
+{
+    set->ranges = NULL;
+    set->num_ranges = 0;
+    set->max_ranges = 0;
+    set->num = 0;
+    set->spare = 0;
+}
+
+void charset_free ( t_char_set *set )
+{
+    free(set->ranges);
+    charset_init(set);
+}
+
+/* Add the code points \c first..last (inclusive) to \c set. Overlapping and
+ * adjacent ranges are joined.
+ */
+bool charset_add ( t_char_set *set, int first, int last )
+{
+    t_char_range *p;
+    int i, j;
+
+    if ( first<0 || last>MAXCODE || last<first )
+    {
+	fprintf(stderr,"error: charset_add: invalid range #%d..#%d\n",first,last);
+	return false;
+    }
+    // skip all ranges in front of the new one
+    for ( i=0; i<set->num_ranges && set->ranges[i].last+1<first; i++ )
+	;
+    // join all ranges touching the new one
+    for ( j=i; j<set->num_ranges && set->ranges[j].first<=last+1; j++ )
+    {
+	if ( set->ranges[j].first < first )
+	    first = set->ranges[j].first;
+	if ( set->ranges[j].last > last )
+	    last = set->ranges[j].last;
+    }
+    if ( j == i )
+    {
+	// nothing to join, insert a new range
+	if ( set->num_ranges >= set->max_ranges )
+	{
+	    p = realloc(set->ranges,(set->max_ranges?2*set->max_ranges:8)*sizeof(t_char_range));
+	    if ( !p )
+	    {
+		fprintf(stderr,"error: charset_add: memory allocation failed\n");
+		return false;
+	    }
+	    set->ranges = p;
+	    set->max_ranges = set->max_ranges?2*set->max_ranges:8;
+	}
+	memmove(&set->ranges[i+1],&set->ranges[i],(set->num_ranges-i)*sizeof(t_char_range));
+	set->num_ranges++;
+    }
+    else if ( j > i+1 )
+    {
+	// ranges i..j-1 become one
+	memmove(&set->ranges[i+1],&set->ranges[j],(set->num_ranges-j)*sizeof(t_char_range));
+	set->num_ranges -= j-i-1;
+    }
+    set->ranges[i].first = first;
+    set->ranges[i].last = last;
+    update_index(set);
+    return true;
+}
+
+/* Add all code points of \c other to \c set.
+ */
+bool charset_merge ( t_char_set *set, const t_char_set *other )
+{
+    int i;
+
+    for ( i=0; i<other->num_ranges; i++ )
+    {
+	if ( !charset_add(set,other->ranges[i].first,other->ranges[i].last) )
+	    return false;
+    }
+    return true;
+}
+
+/* Initialize \c set as copy of \c other.
+ */
+bool charset_copy ( t_char_set *set, const t_char_set *other )
+{
+    charset_init(set);
+    if ( !charset_merge(set,other) )
+	return false;
+    charset_add_spare(set,other->spare);
+    return true;
+}
+
+/* Append \c num glyph indexes without a code point to \c set.
+ */
+void charset_add_spare ( t_char_set *set, int num )
+{
+    set->spare += num;
+    update_index(set);
+}
+
+/* Add the code points of the \c spec to \c set. See the description of the
+ * module for the format.
+ */
+bool charset_parse ( t_char_set *set, const char *spec )
+{
+    const char *ptr = spec;
+    char *next;
+    int first, last;
+    bool hex;
+
+    do
+    {
+	while ( isspace((unsigned char)*ptr) )
+	    ptr++;
+	hex = false;
+	if ( !parse_code(ptr,&next,&first,&hex) )
+	{
+	    fprintf(stderr,"error: invalid code point in '%s'\n",spec);
+	    return false;
+	}
+	last = first;
+	// "U+0020-007E" is read as "U+0020-U+007E"
+	if ( *next=='-' && !parse_code(next+1,&next,&last,&hex) )
+	{
+	    fprintf(stderr,"error: invalid range in '%s'\n",spec);
+	    return false;
+	}
+	while ( isspace((unsigned char)*next) )
+	    next++;
+	if ( *next!=',' && *next!='\0' )
+	{
+	    fprintf(stderr,"error: invalid character set '%s'\n",spec);
+	    return false;
+	}
+	if ( !charset_add(set,first,last) )
+	    return false;
+	ptr = next+1;
+    } while ( *next == ',' );
+    return true;
+}
+
+/* Add all code points used by the UTF-8 text files in the comma separated
+ * list \c files. The code points are collected in a bitmap first, so the
+ * set is build from the final ranges only.
+ */
+bool charset_scan_files ( t_char_set *set, const char *files )
+{
+    char filename[MAXPATH+1];
+    const char *ptr = files;
+    const char *end;
+    uint8_t *used;
+    uint8_t *text;
+    size_t size;
+    size_t pos;
+    bool result = true;
+    int first;
+    int code;
+    int num;
+    int len;
+
+    used = calloc((MAXCODE+1)/8,sizeof(uint8_t));
+    if ( !used )
+    {
+	fprintf(stderr,"error: charset_scan_files: memory allocation failed\n");
+	return false;
+    }
+    while ( result && *ptr )
+    {
+	end = strchr(ptr,',');
+	if ( !end )
+	    end = ptr+strlen(ptr);
+	len = (end-ptr < MAXPATH) ? end-ptr : MAXPATH;
+	memcpy(filename,ptr,len);
+	filename[len] = '\0';
+	ptr = *end ? end+1 : end;
+	if ( !filename[0] )
+	    continue;
+	if ( !read_text_file(filename,&text,&size) )
+	{
+	    result = false;
+	    break;
+	}
+	num = 0;
+	for ( pos=0; pos<size; pos+=len )
+	{
+	    len = decode_utf8(text+pos,size-pos,&code);
+	    if ( len == 0 )
+	    {
+		fprintf(stderr,"warn: %s: invalid UTF-8 at offset %ld\n",filename,(long)pos);
+		len = 1;
+		continue;
+	    }
+	    if ( code<0x20 || (code>=0x7F && code<0xA0) || code==0xFEFF )
+		continue;
+	    if ( !(used[code>>3] & (1<<(code&7))) )
+	    {
+		used[code>>3] |= 1<<(code&7);
+		num++;
+	    }
+	}
+	free(text);
+	if ( is_verbose() )
+	    fprintf(stderr,"info: '%s' adds %d code points\n",filename,num);
+    }
+
+    // add the runs of used code points
+    for ( code=0; result && code<=MAXCODE; code++ )
+    {
+	if ( !(used[code>>3] & (1<<(code&7))) )
+	    continue;
+	first = code;
+	while ( code<MAXCODE && (used[(code+1)>>3] & (1<<((code+1)&7))) )
+	    code++;
+	result = charset_add(set,first,code);
+    }
+    free(used);
+    return result;
+}
+
+bool charset_equal ( const t_char_set *a, const t_char_set *b )
+{
+    int i;
+
+    if ( a->num_ranges!=b->num_ranges || a->spare!=b->spare )
+	return false;
+    for ( i=0; i<a->num_ranges; i++ )
+    {
+	if ( a->ranges[i].first!=b->ranges[i].first || a->ranges[i].last!=b->ranges[i].last )
+	    return false;
+    }
+    return true;
+}
+
+/* Return the glyph index of \c code or -1 if \c code is not in the set.
+ */
+int charset_index ( const t_char_set *set, int code )
+{
+    int lo = 0;
+    int hi = set->num_ranges-1;
+    int mid;
+
+    while ( lo <= hi )
+    {
+	mid = (lo+hi)/2;
+	if ( code < set->ranges[mid].first )
+	    hi = mid-1;
+	else if ( code > set->ranges[mid].last )
+	    lo = mid+1;
+	else
+	    return set->ranges[mid].index + code - set->ranges[mid].first;
+    }
+    return -1;
+}
+
+/* Return the number of ranges with rendered code points. Only a set without
+ * a spare glyph has its end marker in the last range. That range vanishes if
+ * it is the marker only, like with "--from X --to X".
+ */
+int charset_used_ranges ( const t_char_set *set )
+{
+    const t_char_range *r;
+
+    if ( !set->num_ranges || set->spare )
+	return set->num_ranges;
+    r = &set->ranges[set->num_ranges-1];
+    return (r->first==r->last) ? set->num_ranges-1 : set->num_ranges;
+}
+
+/* Return the last rendered code point of the range \c i.
+ */
+int charset_used_last ( const t_char_set *set, int i )
+{
+    if ( set->spare || i!=set->num_ranges-1 )
+	return set->ranges[i].last;
+    return set->ranges[i].last-1;
+}
+
+/* Return the code point of the glyph \c index or -1 if out of range or
+ * spare.
+ */
+int charset_code ( const t_char_set *set, int index )
+{
+    int lo = 0;
+    int hi = set->num_ranges-1;
+    int mid;
+
+    if ( index<0 || index>=set->num-set->spare )
+	return -1;
+    while ( lo < hi )
+    {
+	mid = (lo+hi+1)/2;
+	if ( set->ranges[mid].index <= index )
+	    lo = mid;
+	else
+	    hi = mid-1;
+    }
+    return set->ranges[lo].first + index - set->ranges[lo].index;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Read a single code point. "U+" starts a hex number and sets \c hex,
+ * which is kept for the end of the range. Everything else is read like a C
+ * number.
+ */
+static bool parse_code ( const char *str, char **end, int *code, bool *hex )
+{
+    long val;
+
+    if ( (str[0]=='U' || str[0]=='u') && str[1]=='+' )
+    {
+	*hex = true;
+	str += 2;
+    }
+    if ( *hex )
+    {
+	if ( !isxdigit((unsigned char)str[0]) )
+	    return false;
+	val = strtol(str,end,16);
+    }
+    else
+    {
+	if ( !isdigit((unsigned char)str[0]) )
+	    return false;
+	val = strtol(str,end,0);
+    }
+    if ( val<0 || val>MAXCODE )
+	return false;
+    *code = (int)val;
+    return true;
+}
+
+/* Read the whole file \c filename into an allocated buffer.
+ */
+static bool read_text_file ( const char *filename, uint8_t **text, size_t *size )
+{
+    struct stat st;
+    ssize_t len;
+    int fd;
+
+    fd = open(filename,O_RDONLY);
+    if ( fd < 0 )
+    {
+	fprintf(stderr,"error: unable to open text file '%s'\n",filename);
+	return false;
+    }
+    if ( fstat(fd,&st) != 0 )
+    {
+	fprintf(stderr,"error: unable to get size of '%s'\n",filename);
+	close(fd);
+	return false;
+    }
+    *size = st.st_size;
+    *text = malloc(*size+1);
+    if ( !*text )
+    {
+	fprintf(stderr,"error: read_text_file: memory allocation failed\n");
+	close(fd);
+	return false;
+    }
+    len = read(fd,*text,*size);
+    close(fd);
+    if ( len<0 || (size_t)len!=*size )
+    {
+	fprintf(stderr,"error: unable to read '%s'\n",filename);
+	free(*text);
+	return false;
+    }
+    return true;
+}
+
+/* Decode the UTF-8 sequence at \c p. Return the number of bytes used or 0
+ * if the sequence is invalid (overlong, surrogate, truncated, ...).
+ */
+static int decode_utf8 ( const uint8_t *p, size_t len, int *code )
+{
+    int num;
+    int min;
+    int c;
+    int i;
+
+    if ( p[0] < 0x80 )
+    {
+	*code = p[0];
+	return 1;
+    }
+    if ( (p[0]&0xE0) == 0xC0 )
+    {
+	c = p[0]&0x1F;
+	num = 2;
+	min = 0x80;
+    }
+    else if ( (p[0]&0xF0) == 0xE0 )
+    {
+	c = p[0]&0x0F;
+	num = 3;
+	min = 0x800;
+    }
+    else if ( (p[0]&0xF8) == 0xF0 )
+    {
+	c = p[0]&0x07;
+	num = 4;
+	min = 0x10000;
+    }
+    else
+	return 0;
+    if ( len < (size_t)num )
+	return 0;
+    for ( i=1; i<num; i++ )
+    {
+	if ( (p[i]&0xC0) != 0x80 )
+	    return 0;
+	c = (c<<6) | (p[i]&0x3F);
+    }
+    if ( c<min || c>MAXCODE || (c>=0xD800 && c<=0xDFFF) )
+	return 0;
+    *code = c;
+    return num;
+}
+
+/* Renumber the glyphs after a change of the ranges.
+ */
+static void update_index ( t_char_set *set )
+{
+    int i;
+
+    set->num = 0;
+    for ( i=0; i<set->num_ranges; i++ )
+    {
+	set->ranges[i].index = set->num;
+	set->num += set->ranges[i].last - set->ranges[i].first + 1;
+    }
+    set->num += set->spare;
+}
+
+//}}}
+
+/* ==[End of file]========================================================== */
@@ -0,0 +1,77 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: charset.h
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:21:48 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ *
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#ifndef __CHARSET_H__
+#define __CHARSET_H__ 1
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            TYPEDECLARATIONS                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                     PROTOTYPES OF GLOBAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+void charset_init ( t_char_set *set );
+void charset_free ( t_char_set *set );
+bool charset_add ( t_char_set *set, int first, int last );
+bool charset_merge ( t_char_set *set, const t_char_set *other );
+bool charset_copy ( t_char_set *set, const t_char_set *other );
+void charset_add_spare ( t_char_set *set, int num );
+bool charset_parse ( t_char_set *set, const char *spec );
+bool charset_scan_files ( t_char_set *set, const char *files );
+bool charset_equal ( const t_char_set *a, const t_char_set *b );
+int charset_index ( const t_char_set *set, int code );
+int charset_code ( const t_char_set *set, int index );
+int charset_used_ranges ( const t_char_set *set );
+int charset_used_last ( const t_char_set *set, int i );
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+#endif
+/* ==[End of file]========================================================== */
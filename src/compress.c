@@ -0,0 +1,259 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: compress.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:45:17 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Compression of the rendered glyphs (see --compress). This pass runs after
+ * the renderer. The bytes of each glyph (a matrix or a box) are compressed
+ * on their own, so the glyphs can be decoded in any order. The offsets of
+ * the compressed glyphs are stored in \c compressed_offsets. The buffer of
+ * the renderer is kept, so the writers can still draw the glyphs.
+ *
+ * With --dedup, only the stored glyphs are compressed (see \c num_glyphs).
+ *
+ * The RLE scheme works on bytes. Each code is followed by its data:
+ *
+ *   0x00..0x7F  copy the next (code+1) bytes (1..128)
+ *   0x80..0xBF  (code&0x3F)+1 bytes of 0x00 (1..64)
+ *   0xC0..0xFF  repeat the next byte (code&0x3F)+2 times (2..65)
+ *
+ * Trailing zero bytes are not stored, the decoder fills the rest of the glyph
+ * with zeros. So an empty glyph needs no data at all.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __COMPRESS_C__
+#include "fontgen.h"
+#include "compress.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MAX_LITERAL 128		// max. bytes copied by one code
+#define MAX_ZEROS   64		// max. zero bytes of one code
+#define MAX_REPEAT  65		// max. repeated bytes of one code
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static const uint8_t *glyph_data ( const t_font_definition *fnt, int idx, int *size );
+static int rle_encode ( uint8_t *dst, const uint8_t *src, int size );
+static int run_length ( const uint8_t *src, int size, int max );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+/* Compress all glyphs of \c fnt, if the render options ask for it. The
+ * result is stored in \c compressed, the offsets of the stored glyphs in
+ * \c compressed_offsets. There are num_glyphs+1 offsets, the last one is the
+ * size of the data.
+ */
+bool compress_glyphs ( t_font_definition *fnt )
+{
+    const uint8_t *src;
+    uint8_t *data;
+    uint8_t *p;
+    int *offsets;
+    int size;
+    int total;
+    int idx;
+
+    if ( !fnt || !fnt->buffer )
+    {
+	fprintf(stderr,"error: compress_glyphs: illegal parameters\n");
+	return false;
+    }
+    if ( !fnt->options || fnt->options->compression==COMPRESSION_NONE )
+	return true;
+
+    // the worst case is one code for each literal block
+    total = 0;
+    for ( idx=0; idx<fnt->num_glyphs; idx++ )
+    {
+	glyph_data(fnt,idx,&size);
+	total += size + (size+MAX_LITERAL-1)/MAX_LITERAL;
+    }
+    data = malloc(total?total:1);
+    offsets = malloc((fnt->num_glyphs+1)*sizeof(int));
+    if ( !data || !offsets )
+    {
+	free(data);
+	free(offsets);
+	fprintf(stderr,"error: compress_glyphs: memory allocation failed\n");
+	return false;
+    }
+
+    total = 0;
+    for ( idx=0; idx<fnt->num_glyphs; idx++ )
+    {
+	src = glyph_data(fnt,idx,&size);
+	offsets[idx] = total;
+	total += rle_encode(data+total,src,size);
+    }
+    offsets[fnt->num_glyphs] = total;
+
+    p = realloc(data,total?total:1);
+    if ( p )
+	data = p;
+    fnt->compressed = data;
+    fnt->compressed_size = total;
+    fnt->compressed_offsets = offsets;
+    if ( is_verbose() )
+	fprintf(stderr,"info: compressed %d glyphs to %d bytes\n",fnt->num_glyphs,total);
+    return true;
+}
+
+/* Free the compressed glyphs of \c fnt.
+ */
+void release_compressed ( t_font_definition *fnt )
+{
+    if ( !fnt )
+	return;
+    free(fnt->compressed);
+    free(fnt->compressed_offsets);
+    fnt->compressed = NULL;
+    fnt->compressed_offsets = NULL;
+    fnt->compressed_size = 0;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Return the bytes of the glyph \c idx and their number in \c size. The boxes
+ * of a proportional renderer are stored one after the other, so the next
+ * offset ends a box.
+ */
+static const uint8_t *glyph_data ( const t_font_definition *fnt, int idx, int *size )
+{
+    if ( fnt->boxes )
+    {
+	if ( idx < fnt->num_glyphs-1 )
+	    *size = fnt->boxes[idx+1].offset - fnt->boxes[idx].offset;
+	else
+	    *size = fnt->buffer_size - fnt->boxes[idx].offset;
+	return fnt->buffer + fnt->boxes[idx].offset;
+    }
+    *size = fnt->matrix_size;
+    return fnt->buffer + (fnt->matrix_size)*idx;
+}
+
+/* Encode the \c size bytes of \c src into \c dst and return the number of
+ * bytes written.
+ */
+static int rle_encode ( uint8_t *dst, const uint8_t *src, int size )
+{
+    int pos = 0;
+    int i = 0;
+    int n, k;
+
+    while ( size>0 && !src[size-1] )
+	size--;
+    while ( i < size )
+    {
+	if ( !src[i] )
+	{
+	    n = run_length(src+i,size-i,MAX_ZEROS);
+	    dst[pos++] = 0x80 | (n-1);
+	    i += n;
+	    continue;
+	}
+	n = run_length(src+i,size-i,MAX_REPEAT);
+	if ( n >= 3 )
+	{
+	    dst[pos++] = 0xC0 | (n-2);
+	    dst[pos++] = src[i];
+	    i += n;
+	    continue;
+	}
+	/* collect the literal bytes up to the next run. One or two zeros are
+	 * cheaper inside the literal, so the output is never larger than the
+	 * bytes plus one code for each 128 bytes.
+	 */
+	for ( n=1; i+n<size && n<MAX_LITERAL; n++ )
+	{
+	    if ( run_length(src+i+n,size-i-n,3)==3 )
+		break;
+	}
+	dst[pos++] = n-1;
+	for ( k=0; k<n; k++ )
+	    dst[pos++] = src[i+k];
+	i += n;
+    }
+    return pos;
+}
+
+/* Number of bytes equal to the first one of \c src (max. \c max).
+ */
+static int run_length ( const uint8_t *src, int size, int max )
+{
+    int n = 1;
+
+    while ( n<size && n<max && src[n]==src[0] )
+	n++;
+    return n;
+}
+
+//}}}
+
+/* ==[End of file]========================================================== */
@@ -0,0 +1,66 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: compress.h
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:45:17 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ *
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#ifndef __COMPRESS_H__
+#define __COMPRESS_H__ 1
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            TYPEDECLARATIONS                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                     PROTOTYPES OF GLOBAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+bool compress_glyphs ( t_font_definition *fnt );
+void release_compressed ( t_font_definition *fnt );
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+#endif
+/* ==[End of file]========================================================== */
@@ -0,0 +1,296 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: dedup.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:48:55 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Deduplication of the rendered glyphs (see --dedup). This pass runs after
+ * the renderer and before the compression. Many fonts use the same bitmap
+ * for a lot of characters (e.g. the .notdef box for the control codes). With
+ * --dedup, each different glyph is stored only once.
+ *
+ * The characters are mapped to the stored glyphs by \c glyph_map. The stored
+ * glyphs are kept in the order of their first character, which is noted in
+ * \c glyph_chars. Like the characters, the last stored glyph is the unused
+ * one. Without --dedup, both maps are the identity and \c num_glyphs is
+ * \c num.
+ *
+ * The glyphs are moved to the front of the buffer. The boxes of a
+ * proportional renderer are moved too, so they are indexed by the stored
+ * glyph. Two boxes are only the same, if the bitmap and the position match.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __DEDUP_C__
+#include "fontgen.h"
+#include "dedup.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define FNV_OFFSET 2166136261u	// FNV-1a start value
+#define FNV_PRIME  16777619u	// FNV-1a prime
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static const uint8_t *glyph_data ( const t_font_definition *fnt, int idx, int *size );
+static uint32_t glyph_hash ( const t_font_definition *fnt, int idx );
+static bool same_glyph ( const t_font_definition *fnt, int glyph, int idx );
+static void store_glyph ( t_font_definition *fnt, int idx, int glyph, int *end );
+static uint32_t hash_value ( uint32_t hash, int value );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+/* Store each different glyph of \c fnt only once, if the render options ask
+ * for it. \c glyph_map, \c glyph_chars and \c num_glyphs are set in any case.
+ */
+bool dedup_glyphs ( t_font_definition *fnt )
+{
+    int *table;			// hash table of the stored glyphs
+    unsigned mask;		// size of the table - 1
+    unsigned h;
+    int num;			// number of stored glyphs
+    int end;			// end of the stored boxes
+    int idx;
+
+    if ( !fnt || !fnt->buffer || fnt->num<=0 )
+    {
+	fprintf(stderr,"error: dedup_glyphs: illegal parameters\n");
+	return false;
+    }
+    fnt->glyph_map = malloc(fnt->num*sizeof(int));
+    fnt->glyph_chars = malloc(fnt->num*sizeof(int));
+    if ( !fnt->glyph_map || !fnt->glyph_chars )
+    {
+	release_glyph_map(fnt);
+	fprintf(stderr,"error: dedup_glyphs: memory allocation failed\n");
+	return false;
+    }
+    if ( !fnt->options || !fnt->options->dedup )
+    {
+	for ( idx=0; idx<fnt->num; idx++ )
+	    fnt->glyph_map[idx] = fnt->glyph_chars[idx] = idx;
+	fnt->num_glyphs = fnt->num;
+	return true;
+    }
+
+    // at most half of the table is used, so the probing stops soon
+    for ( mask=1; mask<2*(unsigned)(fnt->num); mask<<=1 )
+	;
+    table = malloc(mask*sizeof(int));
+    if ( !table )
+    {
+	release_glyph_map(fnt);
+	fprintf(stderr,"error: dedup_glyphs: memory allocation failed\n");
+	return false;
+    }
+    memset(table,-1,mask*sizeof(int));
+    mask--;
+
+    num = 0;
+    end = 0;
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	h = glyph_hash(fnt,idx) & mask;
+	while ( table[h]>=0 && !same_glyph(fnt,table[h],idx) )
+	    h = (h+1) & mask;
+	if ( table[h] >= 0 )
+	{
+	    fnt->glyph_map[idx] = table[h];
+	    continue;
+	}
+	store_glyph(fnt,idx,num,&end);
+	table[h] = num;
+	fnt->glyph_map[idx] = num;
+	fnt->glyph_chars[num++] = idx;
+    }
+    // the unused last glyph is kept as end marker
+    store_glyph(fnt,fnt->num-1,num,&end);
+    fnt->glyph_map[fnt->num-1] = num;
+    fnt->glyph_chars[num++] = fnt->num-1;
+    free(table);
+
+    fnt->num_glyphs = num;
+    if ( fnt->boxes )
+	fnt->buffer_size = end;
+    if ( is_verbose() )
+	fprintf(stderr,"info: %d of %d glyphs are unique\n",num-1,fnt->num-1);
+    return true;
+}
+
+/* Free the glyph maps of \c fnt.
+ */
+void release_glyph_map ( t_font_definition *fnt )
+{
+    if ( !fnt )
+	return;
+    free(fnt->glyph_map);
+    free(fnt->glyph_chars);
+    fnt->glyph_map = NULL;
+    fnt->glyph_chars = NULL;
+    fnt->num_glyphs = 0;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Return the bytes of the not yet stored glyph \c idx and their number in
+ * \c size. The glyphs before \c idx are moved to the front only, so the next
+ * box still ends the box \c idx.
+ */
+static const uint8_t *glyph_data ( const t_font_definition *fnt, int idx, int *size )
+{
+    if ( fnt->boxes )
+    {
+	if ( idx < fnt->num-1 )
+	    *size = fnt->boxes[idx+1].offset - fnt->boxes[idx].offset;
+	else
+	    *size = 0;
+	return fnt->buffer + fnt->boxes[idx].offset;
+    }
+    *size = fnt->matrix_size;
+    return fnt->buffer + (fnt->matrix_size)*idx;
+}
+
+/* FNV-1a hash of the glyph \c idx. The position of a box is part of it.
+ */
+static uint32_t glyph_hash ( const t_font_definition *fnt, int idx )
+{
+    const t_glyph_box *b;
+    const uint8_t *data;
+    uint32_t hash = FNV_OFFSET;
+    int size;
+    int i;
+
+    data = glyph_data(fnt,idx,&size);
+    for ( i=0; i<size; i++ )
+	hash = (hash ^ data[i]) * FNV_PRIME;
+    if ( fnt->boxes )
+    {
+	b = &fnt->boxes[idx];
+	hash = hash_value(hash,b->width);
+	hash = hash_value(hash,b->height);
+	hash = hash_value(hash,b->x);
+	hash = hash_value(hash,b->y);
+	hash = hash_value(hash,b->advance);
+    }
+    return hash;
+}
+
+/* Check if the glyph \c idx is the same as the stored glyph \c glyph.
+ */
+static bool same_glyph ( const t_font_definition *fnt, int glyph, int idx )
+{
+    const t_glyph_box *a, *b;
+    const uint8_t *data;
+    int size;
+
+    data = glyph_data(fnt,idx,&size);
+    if ( !fnt->boxes )
+	return memcmp(fnt->buffer+(fnt->matrix_size)*glyph,data,size)==0;
+
+    a = &fnt->boxes[glyph];
+    b = &fnt->boxes[idx];
+    if ( a->width!=b->width || a->height!=b->height || a->x!=b->x || a->y!=b->y ||
+	 a->advance!=b->advance || a->pitch!=b->pitch || a->stride!=b->stride )
+	return false;
+    // same geometry, so the stored box has the same size
+    return memcmp(fnt->buffer+a->offset,data,size)==0;
+}
+
+/* Move the glyph \c idx to the stored glyph \c glyph. Since \c glyph is not
+ * behind \c idx, the glyphs not checked yet are not touched. \c end is the
+ * end of the stored boxes.
+ */
+static void store_glyph ( t_font_definition *fnt, int idx, int glyph, int *end )
+{
+    const uint8_t *data;
+    int size;
+
+    data = glyph_data(fnt,idx,&size);
+    if ( !fnt->boxes )
+    {
+	if ( glyph != idx )
+	    memmove(fnt->buffer+(fnt->matrix_size)*glyph,data,size);
+	return;
+    }
+    memmove(fnt->buffer+(*end),data,size);
+    fnt->boxes[glyph] = fnt->boxes[idx];
+    fnt->boxes[glyph].offset = *end;
+    *end += size;
+}
+
+static uint32_t hash_value ( uint32_t hash, int value )
+{
+    int i;
+
+    for ( i=0; i<4; i++ )
+	hash = (hash ^ ((value>>(8*i))&0xFF)) * FNV_PRIME;
+    return hash;
+}
+
+//}}}
+
+/* ==[End of file]========================================================== */
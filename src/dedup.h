@@ -0,0 +1,66 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: dedup.h
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:48:55 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ *
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#ifndef __DEDUP_H__
+#define __DEDUP_H__ 1
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            TYPEDECLARATIONS                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                     PROTOTYPES OF GLOBAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+bool dedup_glyphs ( t_font_definition *fnt );
+void release_glyph_map ( t_font_definition *fnt );
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+#endif
+/* ==[End of file]========================================================== */
@@ -16,10 +16,17 @@
  */
 
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <ctype.h>
+#include <math.h>
 #include <stdint.h>
 #include <stdbool.h>
 #include <getopt.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
 #include <ft2build.h>
 #include FT_GLYPH_H
 
@@ -27,12 +34,28 @@
 
 #include "config.h"
 #include "fontgen.h"
+#include "manifest.h"
+#include "cache.h"
+#include "charset.h"
+#include "compress.h"
+#include "dedup.h"
+
+#ifdef HAVE_MMAP
+#include <sys/mman.h>
+#endif
 
 // the plugins
 #include "renderer-1bit.h"
+#include "renderer-1bit-vpage.h"
+#include "renderer-1bit-prop.h"
 #include "renderer-2bit.h"
+#include "renderer-2bit-gray.h"
+#include "renderer-gray.h"
 #include "writer-ascii.h"
 #include "writer-c-raw.h"
+#include "writer-bin.h"
+#include "writer-elf.h"
+#include "writer-asm.h"
 
 
 
@@ -40,6 +63,61 @@
 /*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
 /*`========================================================================='*/
 //{{{
+
+/* max. number of variants build by one call (see --variants and --manifest)
+ */
+#define MAXVARIANTS 128
+
+/* max. number of different font files used by one call (see --manifest)
+ */
+#define MAXFONTS 32
+
+/* max. number of writers of one variant (see --writer)
+ */
+#define MAXWRITERS 8
+
+/* number of locks used by the writers (see writer[])
+ */
+#define NUM_WRITER_LOCKS 4
+
+/* Parameters of the 64 bit FNV-1a hash used to detect unchanged inputs
+ */
+#define HASH_INIT  0xcbf29ce484222325ULL
+#define HASH_PRIME 0x00000100000001b3ULL
+
+/* Flags used to load the glyphs. They are part of the key of the glyph cache.
+ */
+#define GLYPH_LOAD_FLAGS FT_LOAD_TARGET_MONO
+
+/* Flags used to load the glyphs for the gray renderers. The glyphs are
+ * rendered with 8 bit coverage.
+ */
+#define GRAY_LOAD_FLAGS FT_LOAD_TARGET_NORMAL
+
+/* Default coverage thresholds of the gray levels 1..3. Each level covers
+ * the same part of 0..255.
+ */
+#define DEFAULT_THRESHOLDS "43,128,213"
+
+/* Range of the gamma of the gray renderers (see --gamma)
+ */
+#define MIN_GAMMA 0.1
+#define MAX_GAMMA 10.0
+
+/* Number of the highest and the lowest glyphs rasterized while searching the
+ * size for a target matrix (see --target-matrix)
+ */
+#define NUM_EXTREMES 4
+
+/* Max. number of searches for a target matrix. Each failed check of the
+ * result adds the glyphs exceeding it to the probed ones.
+ */
+#define MAX_SEARCHES 4
+
+/* Largest size in points tried by the search for a target matrix
+ */
+#define MAX_PT_SIZE 4096
+
 //}}}
 
 /*             .-----------------------------------------------.             */
@@ -63,8 +141,92 @@ typedef struct tagWRITER_LIST
 {
     const char *name;			// name of the plugin to reference it in the CLI
     const t_writer_creator factory;	// factory method
+    int lock;				// index into writer_lock[]
 } t_writer_list;
 
+/* A font file in memory. All faces of the file, regardless of the thread
+ * which uses them, are created from the same bytes.
+ */
+typedef struct tagFONT_FILE
+{
+    char filename[MAXPATH+1];		// the font file
+    FT_Byte *data;			// the content of the file
+    FT_Long size;			// size of the file
+    bool mapped;			// data is a mmap()ed file
+    uint64_t hash;			// hash of the content
+} t_font_file;
+
+/* FreeType library and faces used by one thread. The faces are created on
+ * demand and reused for all variants of the same font file.
+ */
+typedef struct tagRASTERIZER
+{
+    FT_Library library;			// library of this thread
+    FT_Face face[MAXFONTS];		// face of fonts[i] or NULL
+} t_rasterizer;
+
+/* One job of the parallel glyph rasterization. The job handles the slots
+ * \c begin..end-1 of \c gmatrices.
+ */
+typedef struct tagCAPTURE_JOB
+{
+    pthread_t thread;			// the worker thread
+    bool started;			// thread was created successfully
+    const t_font_file *ff;		// the font file to use
+    const t_font_metrics *font;		// size and dpi to use
+    const t_cache_key *key;		// key of the glyph cache (w/o character)
+    t_glyph_matrix *gmatrices;		// shared result array
+    const t_char_set *chars;		// the code points of gmatrices[]
+    int begin;				// first slot of this shard
+    int end;				// first slot behind this shard
+    bool result;			// true if all glyphs are captured
+} t_capture_job;
+
+/* One writer of a variant. The writers of a variant get the same rendered
+ * font and run in parallel.
+ */
+typedef struct tagWRITER_JOB
+{
+    pthread_t thread;			// the worker thread
+    bool started;			// thread was created successfully
+    const t_writer_plugin *writer;	// the writer to run
+    pthread_mutex_t *lock;		// lock of the writer
+    t_font_definition *defs;		// the rendered font (read only)
+    const char *outname;		// basename passed to the writer
+    bool result;			// true if the files are written
+} t_writer_job;
+
+/* One variant of the font to create. In batch mode (see --variants and
+ * --manifest) several variants are build in one run. The captured glyphs and
+ * the metrics only depend on the font file, size, dpi, character set and
+ * origin, so variants which only differ in the renderer or writer share them.
+ */
+typedef struct tagVARIANT
+{
+    int font_file;			// index into fonts[]
+    int pt_size;			// size in points
+    int dpi;				// vertical (or both) dpi
+    int hdpi;				// horizontal dpi. 0 means "same as dpi"
+    t_char_set chars;			// the code points to create
+    int origin;				// forced origin. 0 means "detect"
+    bool calc_baseline;			// use calculated baseline
+    t_pixel_size target;		// search size and dpi for this matrix (or 0x0)
+    t_render_options options;		// options of the renderer
+    const t_renderer_plugin *renderer;	// renderer to use
+    const t_writer_plugin *writer[MAXWRITERS];	// writers to use
+    int writer_index[MAXWRITERS];	// index of each writer into writer[]
+    int num_writers;			// number of used writers
+    char renderer_name[MAXNAME+1];	// name of the renderer
+    char writer_name[MAXNAME+1];	// names of the writers (comma separated)
+    char output[MAXPATH+1];		// basename passed to the writer
+    bool unique_name;			// append size, dpi and renderer to the basename
+    bool claimed;			// taken by a build thread
+    bool result;			// true if build successfully
+    t_font_metrics font;		// metrics, valid if captured is set
+    t_glyph_matrix *captured;		// the captured glyphs
+    t_char_set capture;			// the code points of captured[]
+} t_variant;
+
 
 //}}}
 
@@ -85,20 +247,56 @@ static int size = 0;
 static int forced_origin = 0;
 static int font_from_char = 32;
 static int font_to_char = 126;
+static char font_chars[MAXSPEC+1] = {""};	// empty means "from..to"
+static char subset_files[MAXSPEC+1] = {""};	// text files to collect the chars from
+static t_pixel_size target_matrix = {0,0};	// see --target-matrix
+static char gray_thresholds[MAXNAME+1] = {DEFAULT_THRESHOLDS};	// see --thresholds
+static double gray_gamma = 1.0;		// see --gamma
+static int rotation = 0;		// see --rotate
+static int packing = 0;			// see --pack
+static int compression = COMPRESSION_NONE;	// see --compress
+static bool dedup = false;		// see --dedup
+static char arch[MAXNAME+1] = {DEFAULT_ARCH};		// see --arch
+static char section[MAXNAME+1] = {DEFAULT_SECTION};	// see --section
+static int jobs = 1;			// number of threads
+static int capture_jobs = 1;		// number of rasterizer threads per variant
 static char filename[MAXPATH+1] = {""};
 static char output[MAXPATH+1] = {""};
+static char manifest[MAXPATH+1] = {""};
+static char glyph_cache[MAXPATH+1] = {""};
 
 /* The used plugins.
  */
 static char lookup_renderer[MAXNAME+1] = {"1bit"};
-static const t_renderer_plugin *curr_renderer = (t_renderer_plugin*)0;
-static char lookup_writer[MAXNAME+1] = {"ascii"};
-static const t_writer_plugin *curr_writer = (t_writer_plugin*)0;
+static char lookup_writer[MAXNAME+1] = {"ascii"};	// comma separated list
+static bool writer_given = false;	// lookup_writer is set by --writer
+
+/* The variants to build. Without --variants or --manifest, there is only one
+ * variant defined by the regular options. The specs passed by --variants are
+ * parsed after all options are known, since they use them as defaults.
+ */
+static const char *variant_specs[MAXVARIANTS];
+static int num_variant_specs = 0;
+static t_variant variants[MAXVARIANTS];
+static int num_variants = 0;
 
-/* FreeType related variables
+/* The used font files. Each file is loaded only once.
  */
-static FT_Library library;
-static FT_Face face;
+static t_font_file fonts[MAXFONTS];
+static int num_fonts = 0;
+
+/* Locks for the parallel build. The build threads take the next unclaimed
+ * variants under build_lock. The writers keep their state in static
+ * variables, so each writer may run only once at a time. Different writers
+ * run in parallel, but writers sharing code (asm uses the header of c-raw)
+ * share their lock.
+ */
+static pthread_mutex_t build_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t writer_lock[NUM_WRITER_LOCKS] =
+{
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER,
+    PTHREAD_MUTEX_INITIALIZER, PTHREAD_MUTEX_INITIALIZER
+};
 
 /* Configuration Flags
  */
@@ -106,6 +304,7 @@ static int flag_verbose = 0;		// verbose output
 static int flag_check_only = 0;		// only check metrics,..
 static int flag_calc_baseline = 0;	// use calculated baseline
 static int flag_show_help = 0;		//
+static int flag_force = 0;		// ignore the hash of existing files
 
 /* The options to get parsed
  */
@@ -116,6 +315,7 @@ static struct option long_options[] =
     {"check",     no_argument, &flag_check_only, 1},
     {"calc",      no_argument, &flag_calc_baseline, 1},
     {"help",      no_argument, &flag_show_help, 1},
+    {"force",     no_argument, &flag_force, 1},
     /* These options don’t set a flag. We distinguish them by their indices. */
     {"hdpi",      required_argument, 0, 'H'},
     {"dpi",       required_argument, 0, 'd'},
@@ -125,6 +325,21 @@ static struct option long_options[] =
     {"to",        required_argument, 0, 't'},
     {"renderer",  required_argument, 0, 'R'},
     {"writer",    required_argument, 0, 'W'},
+    {"jobs",      required_argument, 0, 'j'},
+    {"variants",  required_argument, 0, 'V'},
+    {"manifest",  required_argument, 0, 'M'},
+    {"cache",     required_argument, 0, 'K'},
+    {"chars",     required_argument, 0, 'U'},
+    {"subset-from", required_argument, 0, 'S'},
+    {"target-matrix", required_argument, 0, 'T'},
+    {"thresholds", required_argument, 0, 'L'},
+    {"gamma",     required_argument, 0, 'G'},
+    {"rotate",    required_argument, 0, 'r'},
+    {"pack",      required_argument, 0, 'P'},
+    {"compress",  required_argument, 0, 'Z'},
+    {"dedup",     no_argument, 0, 'D'},
+    {"arch",      required_argument, 0, 'A'},
+    {"section",   required_argument, 0, 's'},
     {0, 0, 0, 0}
 };
 
@@ -134,7 +349,12 @@ static struct option long_options[] =
 static const t_renderer_list renderer[] =
 {
     {"1bit", renderer_1bit_creator},
+    {"1bit-vpage", renderer_1bit_vpage_creator},
+    {"1bit-prop", renderer_1bit_prop_creator},
     {"2bit", renderer_2bit_creator},
+    {"2bit-gray", renderer_2bit_gray_creator},
+    {"4bit", renderer_4bit_creator},
+    {"8bit", renderer_8bit_creator},
     {NULL,NULL}
 };
 
@@ -142,9 +362,12 @@ static const t_renderer_list renderer[] =
  */
 static const t_writer_list writer[] =
 {
-    {"c-raw", writer_c_raw_creator},
-    {"ascii", writer_ascii_creator},
-    {NULL,NULL}
+    {"c-raw", writer_c_raw_creator, 0},
+    {"ascii", writer_ascii_creator, 1},
+    {"bin", writer_bin_creator, 2},
+    {"elf", writer_elf_creator, 3},
+    {"asm", writer_asm_creator, 0},
+    {NULL,NULL,0}
 };
 
 
@@ -156,13 +379,40 @@ static const t_writer_list writer[] =
 //{{{
 
 static void usage ( void );
-static bool find_renderer ( void );
-static bool find_writer ( void );
+static const t_renderer_plugin *find_renderer ( const char *name );
+static int find_writer ( const char *name );
+static int add_font_file ( const char *filename );
+static bool add_variant ( const t_variant *tmpl, const char *renderer_name, const char *writer_name );
+static bool parse_variants ( const char *spec, const t_variant *tmpl );
+static bool add_manifest_target ( const t_manifest_target *target );
+static bool init_char_set ( t_char_set *set, const char *spec, const char *files, int from, int to );
+static bool init_render_options ( t_render_options *opt, const char *thresholds, double gamma, int rotation, int packing );
 static bool generate_font ( void );
-static bool prepare_font_creation ( t_font_metrics *font, const char *filename, int size, int preset_origin );
-static bool check_font_metrics ( t_font_metrics *font );
-static t_glyph_matrix *create_glyph_matrices ( const t_font_metrics *font );
-static bool create_glyph ( FT_Glyph *glyph, int character );
+static bool same_capture ( const t_variant *a, const t_variant *b );
+static void *build_worker ( void *arg );
+static bool generate_variant ( t_rasterizer *r, t_variant *v );
+static bool run_writers ( t_variant *v, t_font_definition *defs, const char *outname );
+static void *writer_worker ( void *arg );
+static bool prepare_font_creation ( t_font_metrics *font, const char *filename, int size, int dpi, int hdpi, int preset_origin );
+static bool solve_target_matrix ( t_rasterizer *r, t_variant *v );
+static int find_extreme_glyphs ( FT_Face fc, int *codes );
+static bool search_target_matrix ( FT_Face fc, const int *codes, int num, int load_flags, t_variant *v );
+static bool probe_matrix ( FT_Face fc, const int *codes, int num, int load_flags, int size, int dpi, int hdpi, t_pixel_size *matrix, int *highest, int *lowest );
+static uint64_t hash_bytes ( uint64_t hash, const void *data, size_t len );
+static uint64_t variant_hash ( const t_variant *v, const char *outname );
+static bool is_uptodate ( t_variant *v, const char *outname, uint64_t hash );
+static bool load_font_file ( t_font_file *ff );
+static void release_font_files ( void );
+static bool init_rasterizer ( t_rasterizer *r );
+static FT_Face get_face ( t_rasterizer *r, int font_file );
+static void done_rasterizer ( t_rasterizer *r );
+static t_glyph_matrix *capture_glyph_matrices ( FT_Face fc, const t_font_file *ff, const t_font_metrics *font, const t_char_set *chars, int load_flags );
+static void *capture_worker ( void *arg );
+static bool capture_glyph ( FT_Face fc, const t_cache_key *key, t_glyph_matrix *gm, int character );
+static void free_glyph_matrices ( t_glyph_matrix *gmatrices, int num );
+static bool check_font_metrics ( FT_Face fc, t_variant *v );
+static t_glyph_matrix *create_glyph_matrices ( t_variant *v );
+static bool create_glyph ( FT_Face fc, FT_Glyph *glyph, int character, int load_flags );
 static inline int max ( int a, int b );
 
 //}}}
@@ -182,7 +432,7 @@ int main ( int argc, char **argv )
     fprintf(stderr,"%s -- font generation helper\n\n",PACKAGE_STRING);
     do
     {
-	c = getopt_long(argc,argv,"?vcCH:d:o:O:f:t:R:W:",long_options,&option_index);
+	c = getopt_long(argc,argv,"?vcCFH:d:o:O:f:t:R:W:j:V:M:K:U:S:T:L:G:r:P:Z:DA:s:",long_options,&option_index);
 	switch ( c )
 	{
 	    case 0:
@@ -210,6 +460,9 @@ int main ( int argc, char **argv )
 	    case 'C':
 		flag_calc_baseline = 1;
 		break;
+	    case 'F':
+		flag_force = 1;
+		break;
 	    case '?':
 		flag_show_help = 1;
 		break;
@@ -276,10 +529,185 @@ int main ( int argc, char **argv )
 	    case 'W':
 		if ( optarg )
 		{
-		    strncpy(lookup_writer,optarg,MAXNAME);
-		    lookup_writer[MAXNAME]='\0';
+		    // a repeated -W adds the writers to the list
+		    if ( !writer_given )
+			lookup_writer[0] = '\0';
+		    if ( strlen(lookup_writer)+strlen(optarg)+1 > MAXNAME )
+		    {
+			fprintf(stderr,"error: too many writers for option -W\n");
+			return 1;
+		    }
+		    if ( lookup_writer[0] )
+			strcat(lookup_writer,",");
+		    strcat(lookup_writer,optarg);
+		    writer_given = true;
+		    if ( flag_verbose )
+			fprintf(stderr,"info: writer to lookup '%s'\n",optarg);
+		}
+		break;
+	    case 'V':
+		if ( optarg )
+		{
+		    if ( num_variant_specs >= MAXVARIANTS )
+		    {
+			fprintf(stderr,"error: too many variant specs for option -V\n");
+			return 1;
+		    }
+		    variant_specs[num_variant_specs++] = optarg;
+		}
+		break;
+	    case 'M':
+		if ( optarg )
+		{
+		    strncpy(manifest,optarg,MAXPATH);
+		    manifest[MAXPATH]='\0';
+		    if ( flag_verbose )
+			fprintf(stderr,"info: use manifest '%s'\n",manifest);
+		}
+		break;
+	    case 'U':
+		if ( optarg )
+		{
+		    strncpy(font_chars,optarg,MAXSPEC);
+		    font_chars[MAXSPEC]='\0';
+		    if ( flag_verbose )
+			fprintf(stderr,"info: character set '%s'\n",font_chars);
+		}
+		break;
+	    case 'T':
+		if ( optarg )
+		{
+		    if ( sscanf(optarg,"%dx%d",&target_matrix.width,&target_matrix.height)!=2 ||
+			 target_matrix.width<=0 || target_matrix.height<=0 )
+		    {
+			fprintf(stderr,"error: invalid parameter (%s) for option -T\n",optarg);
+			return 1;
+		    }
+		    if ( flag_verbose )
+			fprintf(stderr,"info: search size for a %dx%d matrix\n",target_matrix.width,target_matrix.height);
+		}
+		break;
+	    case 'L':
+		if ( optarg )
+		{
+		    strncpy(gray_thresholds,optarg,MAXNAME);
+		    gray_thresholds[MAXNAME]='\0';
+		    if ( flag_verbose )
+			fprintf(stderr,"info: gray thresholds '%s'\n",gray_thresholds);
+		}
+		break;
+	    case 'G':
+		if ( optarg )
+		{
+		    gray_gamma = atof(optarg);
+		    if ( gray_gamma<MIN_GAMMA || gray_gamma>MAX_GAMMA )
+		    {
+			fprintf(stderr,"error: invalid parameter (%s) for option -G\n",optarg);
+			return 1;
+		    }
+		    if ( flag_verbose )
+			fprintf(stderr,"info: gamma set to %g\n",gray_gamma);
+		}
+		break;
+	    case 'r':
+		if ( optarg )
+		{
+		    rotation = atoi(optarg);
+		    if ( rotation!=0 && rotation!=90 && rotation!=180 && rotation!=270 )
+		    {
+			fprintf(stderr,"error: invalid parameter (%s) for option -r\n",optarg);
+			return 1;
+		    }
+		    if ( flag_verbose )
+			fprintf(stderr,"info: rotate matrices by %d degrees\n",rotation);
+		}
+		break;
+	    case 'P':
+		if ( optarg )
+		{
+		    packing = atoi(optarg);
+		    if ( packing!=0 && packing!=1 && packing!=2 && packing!=4 )
+		    {
+			fprintf(stderr,"error: invalid parameter (%s) for option -P\n",optarg);
+			return 1;
+		    }
+		    if ( flag_verbose )
+			fprintf(stderr,"info: pack glyphs aligned to %d bytes\n",packing);
+		}
+		break;
+	    case 'Z':
+		if ( optarg )
+		{
+		    if ( strcmp(optarg,"rle")==0 )
+			compression = COMPRESSION_RLE;
+		    else if ( strcmp(optarg,"none")==0 )
+			compression = COMPRESSION_NONE;
+		    else
+		    {
+			fprintf(stderr,"error: invalid parameter (%s) for option -Z\n",optarg);
+			return 1;
+		    }
+		    if ( flag_verbose )
+			fprintf(stderr,"info: compression '%s'\n",optarg);
+		}
+		break;
+	    case 'D':
+		dedup = true;
+		break;
+	    case 'A':
+		if ( optarg )
+		{
+		    strncpy(arch,optarg,MAXNAME);
+		    arch[MAXNAME]='\0';
+		    if ( flag_verbose )
+			fprintf(stderr,"info: object files for '%s'\n",arch);
+		}
+		break;
+	    case 's':
+		if ( optarg )
+		{
+		    strncpy(section,optarg,MAXNAME);
+		    section[MAXNAME]='\0';
+		    if ( flag_verbose )
+			fprintf(stderr,"info: font data in section '%s'\n",section);
+		}
+		break;
+	    case 'S':
+		if ( optarg )
+		{
+		    if ( strlen(subset_files)+strlen(optarg)+1 > MAXSPEC )
+		    {
+			fprintf(stderr,"error: too many files for option -S\n");
+			return 1;
+		    }
+		    if ( subset_files[0] )
+			strcat(subset_files,",");
+		    strcat(subset_files,optarg);
+		    if ( flag_verbose )
+			fprintf(stderr,"info: collect the characters of '%s'\n",optarg);
+		}
+		break;
+	    case 'K':
+		if ( optarg )
+		{
+		    strncpy(glyph_cache,optarg,MAXPATH);
+		    glyph_cache[MAXPATH]='\0';
+		    if ( flag_verbose )
+			fprintf(stderr,"info: use glyph cache '%s'\n",glyph_cache);
+		}
+		break;
+	    case 'j':
+		if ( optarg )
+		{
+		    val = atoi(optarg);
+		    if ( val<=0 )
+		    {
+			fprintf(stderr,"error: invalid parameter (%s) for option -j\n",optarg);
+			return 1;
+		    }
+		    jobs = val;
 		    if ( flag_verbose )
-			fprintf(stderr,"info: writer to lookup '%s'\n",lookup_writer);
+			fprintf(stderr,"info: use %d jobs\n",jobs);
 		}
 		break;
 	    case 'f':
@@ -291,7 +719,7 @@ int main ( int argc, char **argv )
 			fprintf(stderr,"error: invalid parameter (%s) for option -f\n",optarg);
 			return 1;
 		    }
-		    if ( val<0 || val>255 )
+		    if ( val<0 || val>MAXCODE )
 		    {
 			fprintf(stderr,"error: parameter %d for option -f out of range\n",val);
 			return 1;
@@ -310,7 +738,7 @@ int main ( int argc, char **argv )
 			fprintf(stderr,"error: invalid parameter (%s) for option -t\n",optarg);
 			return 1;
 		    }
-		    if ( val<0 || val>255 )
+		    if ( val<0 || val>MAXCODE )
 		    {
 			fprintf(stderr,"error: parameter %d for option -t out of range\n",val);
 			return 1;
@@ -323,7 +751,30 @@ int main ( int argc, char **argv )
 	}
     } while (!done);
 
-    if ( optind < argc )
+    if ( manifest[0] )
+    {
+	// the fonts and sizes are part of the manifest
+	if ( num_variant_specs || optind < argc )
+	{
+	    fprintf(stderr,"error: no font or variants allowed with a manifest\n");
+	    return 1;
+	}
+    }
+    else if ( num_variant_specs && target_matrix.width )
+    {
+	fprintf(stderr,"error: no variants allowed with a target matrix\n");
+	return 1;
+    }
+    else if ( (num_variant_specs || target_matrix.width) && (argc-optind) == 1 )
+    {
+	// in batch mode, the sizes are part of the variants. With a target
+	// matrix, the size is searched.
+	strncpy(filename,argv[optind++],MAXPATH);
+	filename[MAXPATH]='\0';
+	if ( flag_verbose )
+	    fprintf(stderr,"info: use font file '%s'\n",filename);
+    }
+    else if ( optind < argc )
     {
 	if ( (argc-optind) >= 2 )
 	{
@@ -350,12 +801,12 @@ int main ( int argc, char **argv )
 	else
 	    flag_show_help = true;
 
-    if ( size <= 0 )
+    if ( size <= 0 && !num_variant_specs && !manifest[0] && !target_matrix.width )
     {
 	fprintf(stderr,"error: font size not specified\n");
 	return 1;
     }
-    if ( filename[0] == '\0' )
+    if ( filename[0] == '\0' && !manifest[0] )
     {
 	fprintf(stderr,"error: font file not specified\n");
 	return 1;
@@ -378,15 +829,83 @@ int main ( int argc, char **argv )
         font_to_char = tmp;
     }
 
-    if ( !find_renderer() )
+    if ( manifest[0] )
     {
-	fprintf(stderr,"error: don't know renderer '%s'\n",lookup_renderer);
-	return 1;
+	t_manifest_target defaults;
+
+	// the regular options are the defaults of the manifest
+	defaults.font[0] = '\0';
+	strncpy(defaults.output,output,MAXPATH);
+	defaults.output[MAXPATH]='\0';
+	defaults.pt_size = size;
+	defaults.dpi = dpi;
+	defaults.hdpi = hdpi;
+	defaults.from = font_from_char;
+	defaults.to = font_to_char;
+	strncpy(defaults.chars,font_chars,MAXSPEC);
+	defaults.chars[MAXSPEC]='\0';
+	strncpy(defaults.subset,subset_files,MAXSPEC);
+	defaults.subset[MAXSPEC]='\0';
+	defaults.origin = forced_origin;
+	defaults.calc = flag_calc_baseline;
+	defaults.target = target_matrix;
+	strncpy(defaults.thresholds,gray_thresholds,MAXNAME);
+	defaults.thresholds[MAXNAME]='\0';
+	defaults.gamma = gray_gamma;
+	defaults.rotation = rotation;
+	defaults.packing = packing;
+	defaults.compression = compression;
+	defaults.dedup = dedup;
+	strncpy(defaults.arch,arch,MAXNAME);
+	defaults.arch[MAXNAME]='\0';
+	strncpy(defaults.section,section,MAXNAME);
+	defaults.section[MAXNAME]='\0';
+	strncpy(defaults.renderer,lookup_renderer,MAXNAME);
+	defaults.renderer[MAXNAME]='\0';
+	strncpy(defaults.writer,lookup_writer,MAXNAME);
+	defaults.writer[MAXNAME]='\0';
+	if ( !read_manifest(manifest,&defaults,add_manifest_target) )
+	    return 1;
     }
-    if ( !find_writer() )
+    else
     {
-	fprintf(stderr,"error: don't know writer '%s'\n",lookup_writer);
-	return 1;
+	t_variant tmpl;
+
+	tmpl.font_file = add_font_file(filename);
+	if ( tmpl.font_file < 0 )
+	    return 1;
+	tmpl.pt_size = size;
+	tmpl.dpi = dpi;
+	tmpl.hdpi = hdpi;
+	charset_init(&tmpl.chars);
+	if ( !init_char_set(&tmpl.chars,font_chars,subset_files,font_from_char,font_to_char) )
+	    return 1;
+	tmpl.origin = forced_origin;
+	tmpl.calc_baseline = flag_calc_baseline;
+	tmpl.target = target_matrix;
+	if ( !init_render_options(&tmpl.options,gray_thresholds,gray_gamma,rotation,packing) )
+	    return 1;
+	tmpl.options.compression = compression;
+	tmpl.options.dedup = dedup;
+	strncpy(tmpl.options.arch,arch,MAXNAME);
+	tmpl.options.arch[MAXNAME]='\0';
+	strncpy(tmpl.options.section,section,MAXNAME);
+	tmpl.options.section[MAXNAME]='\0';
+	strncpy(tmpl.output,output,MAXPATH);
+	tmpl.output[MAXPATH]='\0';
+	tmpl.unique_name = (num_variant_specs>0);
+	if ( num_variant_specs )
+	{
+	    for ( val=0; val<num_variant_specs; val++ )
+	    {
+		if ( !parse_variants(variant_specs[val],&tmpl) )
+		    return 1;
+	    }
+	}
+	else if ( !add_variant(&tmpl,lookup_renderer,lookup_writer) )
+	    return 1;
+	// each variant has its own copy of the chars
+	charset_free(&tmpl.chars);
     }
 
     return generate_font()?0:2;
@@ -405,6 +924,59 @@ bool is_verbose (void)
     return flag_verbose;
 }
 
+/* Check if the file \c filename contains the line written with HASH_FORMAT for
+ * \c hash. Only the head of the file is searched.
+ */
+bool check_file_hash ( const char *filename, uint64_t hash )
+{
+    char expected[MAXNAME+1];
+    char line[MAXPATH+1];
+    bool found = false;
+    int lines = 0;
+    FILE *f;
+
+    f = fopen(filename,"r");
+    if ( !f )
+	return false;
+    snprintf(expected,MAXNAME,HASH_FORMAT,(unsigned long long)hash);
+    expected[MAXNAME]='\0';
+    while ( !found && lines++<50 && fgets(line,sizeof(line),f) )
+	found = (strstr(line,expected)!=NULL);
+    fclose(f);
+    return found;
+}
+
+/* Open the output file \c filename. The data is written into the temporary
+ * file "<filename>.tmp" and close_output() renames it. So a file cut short by
+ * a crash or a full disk never replaces the output and its hash is not taken
+ * as up to date.
+ */
+FILE *open_output ( const char *filename, const char *mode )
+{
+    char name[MAXPATH+5];
+
+    snprintf(name,sizeof(name),"%s.tmp",filename);
+    return fopen(name,mode);
+}
+
+/* Close the file \c f opened by open_output(). If \c keep is set, the
+ * temporary file replaces \c filename, otherwise it is removed. Returns false
+ * if the file could not be written.
+ */
+bool close_output ( FILE *f, const char *filename, bool keep )
+{
+    char name[MAXPATH+5];
+    bool result;
+
+    snprintf(name,sizeof(name),"%s.tmp",filename);
+    result = (fclose(f)==0);
+    if ( result && keep )
+	result = (rename(name,filename)==0);
+    if ( !result || !keep )
+	remove(name);
+    return result;
+}
+
 //}}}
 
 /*+=========================================================================+*/
@@ -416,6 +988,9 @@ static void usage ( void )
 {
     fprintf(stderr,"SYNOPSIS\n");
     fprintf(stderr,"  %s [options] pt-size font\n",PACKAGE);
+    fprintf(stderr,"  %s [options] --target-matrix <w>x<h> font\n",PACKAGE);
+    fprintf(stderr,"  %s [options] --variants <spec> [--variants <spec>...] font\n",PACKAGE);
+    fprintf(stderr,"  %s [options] --manifest <file>\n",PACKAGE);
     fprintf(stderr,"\nOPTIONS\n");
     fprintf(stderr,"  -d|--dpi <num>       set a special dpi value (default 72)\n");
     fprintf(stderr,"  -H|--hdpi <num>      set a special hor. dpi value (default is same as dpi)\n");
@@ -424,159 +999,750 @@ static void usage ( void )
     fprintf(stderr,"  -o|--output <name>   force a basename (without extension).\n");
     fprintf(stderr,"  -f|--from <idx>      start rendering with character code <idx>.\n");
     fprintf(stderr,"  -t|--to <idx>        stop rendering at character code <idx>.\n");
+    fprintf(stderr,"  -U|--chars <set>     render the code points of <set> instead of from..to.\n");
+    fprintf(stderr,"                       e.g. 'U+0020-007E,U+00A0-017F,U+20AC'\n");
+    fprintf(stderr,"  -S|--subset-from <file>\n");
+    fprintf(stderr,"                       render the code points used by the UTF-8 text <file>.\n");
+    fprintf(stderr,"                       Can be repeated. Combined with --chars if given.\n");
     fprintf(stderr,"  -R|--renderer <name> use renderer <name> (default '1pix')\n");
-    fprintf(stderr,"  -W|--writer <name>   use writerer <name> (default 'ascii')\n");
+    fprintf(stderr,"  -W|--writer <name>   use writerer <name> (default 'ascii'). Can be repeated\n");
+    fprintf(stderr,"                       or a comma separated list. All writers get the same\n");
+    fprintf(stderr,"                       rendered font and run in parallel.\n");
+    fprintf(stderr,"  -j|--jobs <num>      build with <num> threads (default 1)\n");
+    fprintf(stderr,"  -V|--variants <spec> build several variants at once. The <spec> is\n");
+    fprintf(stderr,"                       <size>[,<size>...][@<dpi>[x<hdpi>]][:<renderer>[:<writer>]]\n");
+    fprintf(stderr,"                       e.g. '16,20,24@72x46:2bit:c-raw'. Missing parts are\n");
+    fprintf(stderr,"                       taken from the options above. The output names are\n");
+    fprintf(stderr,"                       <name>_<size>_<dpi>x<hdpi>_<renderer>.\n");
+    fprintf(stderr,"  -M|--manifest <file> build all targets of the manifest <file>. The options\n");
+    fprintf(stderr,"                       above are the defaults of the targets. With --jobs,\n");
+    fprintf(stderr,"                       independent targets are build in parallel.\n");
+    fprintf(stderr,"  -T|--target-matrix <w>x<h>\n");
+    fprintf(stderr,"                       search size, dpi and hdpi for a matrix of <w>x<h>\n");
+    fprintf(stderr,"                       pixels. The dpi value is used as starting point.\n");
+    fprintf(stderr,"  -L|--thresholds <a>,<b>,<c>\n");
+    fprintf(stderr,"                       min. coverage (1..255) of the gray levels 1..3 used\n");
+    fprintf(stderr,"                       by the gray renderers (default '%s').\n",DEFAULT_THRESHOLDS);
+    fprintf(stderr,"  -G|--gamma <g>       gamma of the gray renderers (default 1.0). Values\n");
+    fprintf(stderr,"                       above 1 make partly covered pixels darker.\n");
+    fprintf(stderr,"  -r|--rotate <deg>    rotate the matrices clockwise by 90, 180 or 270\n");
+    fprintf(stderr,"                       degrees (not with 1bit-vpage).\n");
+    fprintf(stderr,"  -P|--pack <align>    store the rows of each glyph without padding bits.\n");
+    fprintf(stderr,"                       The glyphs are aligned to <align> (1, 2 or 4) bytes.\n");
+    fprintf(stderr,"  -Z|--compress <type> compress each glyph. <type> is 'rle' or 'none'. The\n");
+    fprintf(stderr,"                       c-raw writer adds the offsets and a decoder.\n");
+    fprintf(stderr,"  -D|--dedup           store equal glyphs only once. The c-raw writer adds\n");
+    fprintf(stderr,"                       a table with the glyph of each character.\n");
+    fprintf(stderr,"  -A|--arch <name>     machine of the elf writer: arm, aarch64, riscv32,\n");
+    fprintf(stderr,"                       riscv64, i386, x86_64 or xtensa (default '%s').\n",DEFAULT_ARCH);
+    fprintf(stderr,"  -s|--section <name>  section of the elf and asm writers (default '%s').\n",DEFAULT_SECTION);
+    fprintf(stderr,"  -K|--cache <file>    keep the rasterized glyphs in <file> and reuse them\n");
+    fprintf(stderr,"                       in the next runs.\n");
     fprintf(stderr,"  -v|--verbose         enable more verbose messages.\n");
     fprintf(stderr,"  -c|--check           check metrics only. No fonts are generated.\n");
+    fprintf(stderr,"  -F|--force           generate the files even if font and options are unchanged.\n");
     fprintf(stderr,"\nRENDERDER\n");
     fprintf(stderr,"  1bit                 1 bit for each pixel in the fix matrix (monospaced)\n");
+    fprintf(stderr,"  1bit-vpage           1 bit for each pixel, pages of 8 rows with one byte\n");
+    fprintf(stderr,"                       per column (SSD1306 layout, bit 0 is the top row)\n");
+    fprintf(stderr,"  1bit-prop            1 bit for each pixel, each glyph cropped to its ink\n");
+    fprintf(stderr,"                       box (proportional, with a table of the boxes)\n");
     fprintf(stderr,"  2bit                 2 bits for each pixel in the fix matrix (monospaced)\n");
+    fprintf(stderr,"  2bit-gray            2 bits gray level (antialiased) for each pixel\n");
+    fprintf(stderr,"  4bit                 4 bits gray level (antialiased) for each pixel\n");
+    fprintf(stderr,"  8bit                 8 bits gray level (antialiased) for each pixel\n");
     fprintf(stderr,"\nWRITER\n");
     fprintf(stderr,"  ascii                simple ASCII arts of the font\n");
     fprintf(stderr,"  c-raw                raw C-source of the final matrix data\n");
+    fprintf(stderr,"  bin                  binary file (little endian) with a header, the tables\n");
+    fprintf(stderr,"                       and the matrix data. It can be used in place.\n");
+    fprintf(stderr,"  elf                  relocatable object file with the data of 'bin' in a\n");
+    fprintf(stderr,"                       section and symbols for its parts.\n");
+    fprintf(stderr,"  asm                  header of 'c-raw', the data as <name>_data.bin and an\n");
+    fprintf(stderr,"                       assembler file <name>.S which includes it (.incbin).\n");
 }
 
-static bool find_renderer ( void )
+static const t_renderer_plugin *find_renderer ( const char *name )
 {
     int i = 0;
     while ( renderer[i].factory )
     {
-	if ( strcmp(renderer[i].name,lookup_renderer)==0 )
-	{
-	    curr_renderer = renderer[i].factory();
-	    return curr_renderer!=0;
-	}
+	if ( strcmp(renderer[i].name,name)==0 )
+	    return renderer[i].factory();
 	++i;
     }
-    return false;
+    return NULL;
 }
 
-static bool find_writer ( void )
+/* Return the index of the writer \c name in writer[] or -1.
+ */
+static int find_writer ( const char *name )
 {
     int i = 0;
     while ( writer[i].factory )
     {
-	if ( strcmp(writer[i].name,lookup_writer)==0 )
-	{
-	    curr_writer = writer[i].factory();
-	    return curr_writer!=0;
-	}
+	if ( strcmp(writer[i].name,name)==0 )
+	    return i;
 	++i;
     }
-    return false;
+    return -1;
 }
 
-/* Combine all the functions to create the font.
+/* Return the index of \c filename in fonts[]. A new file is appended, but
+ * not loaded yet.
  */
-static bool generate_font ( void )
+static int add_font_file ( const char *filename )
 {
-    t_font_definition defs;
-    t_font_metrics font;
-    t_glyph_matrix *gmatrices;
-    bool result;
-    int err;
+    int i;
 
-    err = FT_Init_FreeType(&library);
-    if ( err )
-    {
-        fprintf(stderr,"error: init FreeType failed (%d)\n",err);
-        return false;
-    }
-    if ( !prepare_font_creation(&font,filename,size,forced_origin) )
-	return false;
-    err = FT_New_Face(library,filename,0,&face);
-    if ( err )
+    for ( i=0; i<num_fonts; i++ )
     {
-        fprintf(stderr,"error: create of FreeType face failed (%d)\n",err);
-        FT_Done_FreeType(library);
-        return false;
+	if ( strcmp(fonts[i].filename,filename)==0 )
+	    return i;
     }
-    if ( !check_font_metrics(&font) )
+    if ( num_fonts >= MAXFONTS )
     {
-        // FT_Done_Face(face);
-        FT_Done_FreeType(library);
-	return false;
+	fprintf(stderr,"error: too many font files (max. %d)\n",MAXFONTS);
+	return -1;
     }
+    strncpy(fonts[num_fonts].filename,filename,MAXPATH);
+    fonts[num_fonts].filename[MAXPATH]='\0';
+    fonts[num_fonts].data = NULL;
+    fonts[num_fonts].size = 0;
+    fonts[num_fonts].mapped = false;
+    return num_fonts++;
+}
 
-    if ( flag_check_only )		// if we only check the metrics,
-    {
-	// FT_Done_Face(face);
-	FT_Done_FreeType(library);
-	return true;
-    }
-    if ( font.baseline > 0 )
+/* Append a variant to the list of variants to build. The settings are taken
+ * from \c tmpl. The plugins are looked up here, so unknown names are reported
+ * before anything is generated. \c writer_name is a comma separated list of
+ * writers, which all get the same rendered font.
+ */
+static bool add_variant ( const t_variant *tmpl, const char *renderer_name, const char *writer_name )
+{
+    char names[MAXNAME+1];
+    char *name;
+    char *next;
+    t_variant *v;
+    int i, k;
+
+    if ( num_variants >= MAXVARIANTS )
     {
-	fprintf(stderr,"error: illegal baseline! Must be less than 0! (%d)\n",font.baseline);
-	// FT_Done_Face(face);
-	FT_Done_FreeType(library);
+	fprintf(stderr,"error: too many variants (max. %d)\n",MAXVARIANTS);
 	return false;
     }
-
-    if ( !curr_renderer || !curr_writer )
+    v = &variants[num_variants];
+    *v = *tmpl;
+    v->claimed = false;
+    v->result = false;
+    v->captured = NULL;
+    charset_init(&v->capture);
+    if ( !charset_copy(&v->chars,&tmpl->chars) )
+	return false;
+    v->renderer = find_renderer(renderer_name);
+    if ( !v->renderer )
     {
-        fprintf(stderr,"fatal: bad setup of renderer/writer \n");
-	// FT_Done_Face(face);
-	FT_Done_FreeType(library);
-        return false;
+	fprintf(stderr,"error: don't know renderer '%s'\n",renderer_name);
+	return false;
     }
-
-    if ( flag_calc_baseline )
-	font.baseline = font.calculated_baseline;
-    else
-	font.baseline = font.detected_baseline;
-
-    gmatrices = create_glyph_matrices(&font);
-    result = curr_renderer->init(&defs,&font,font_from_char,font_to_char);
-    if ( result )
+    strncpy(names,writer_name,MAXNAME);
+    names[MAXNAME]='\0';
+    v->num_writers = 0;
+    for ( name=names; name; name=next )
     {
-	result = curr_renderer->generate(&defs,gmatrices);
-	if ( result )
+	next = strchr(name,',');
+	if ( next )
+	    *next++ = '\0';
+	// "c-raw, ascii" is read as "c-raw,ascii"
+	while ( isspace((unsigned char)*name) )
+	    name++;
+	for ( i=strlen(name); i>0 && isspace((unsigned char)name[i-1]); i-- )
+	    name[i-1] = '\0';
+	i = find_writer(name);
+	if ( i < 0 )
+	{
+	    fprintf(stderr,"error: don't know writer '%s'\n",name);
+	    return false;
+	}
+	for ( k=0; k<v->num_writers; k++ )
+	{
+	    if ( v->writer_index[k]==i )
+	    {
+		fprintf(stderr,"error: writer '%s' is used twice\n",name);
+		return false;
+	    }
+	}
+	if ( v->num_writers >= MAXWRITERS )
 	{
-	    result = curr_writer->init(&defs,output);
-	    if ( result )
-		result = curr_writer->create(&defs);
-	    if ( result )
-		curr_writer->done(&defs);
+	    fprintf(stderr,"error: too many writers (max. %d)\n",MAXWRITERS);
+	    return false;
 	}
-	curr_renderer->done(&defs);
+	v->writer[v->num_writers] = writer[i].factory();
+	v->writer_index[v->num_writers++] = i;
     }
-    // TODO: free gmatrices? no, we leave
-
-    //FT_Done_Face(face);
-    FT_Done_FreeType(library);
-    return result;
+    strncpy(v->renderer_name,renderer_name,MAXNAME);
+    v->renderer_name[MAXNAME]='\0';
+    strncpy(v->writer_name,writer_name,MAXNAME);
+    v->writer_name[MAXNAME]='\0';
+    num_variants++;
+    return true;
 }
 
-
-/* Prepare the font generation. This includes the initialisation of \c font.
- * Sone variables are set based on the commandline options.
+/* Parse one variant spec of the form
+ *
+ *   <size>[,<size>...][@<dpi>[x<hdpi>]][:<renderer>[:<writer>]]
+ *
+ * and add a variant for each size. Missing parts are taken from \c tmpl and
+ * the regular options.
  */
-static bool prepare_font_creation ( t_font_metrics *font, const char *filename, int size, int preset_origin )
+static bool parse_variants ( const char *spec, const t_variant *tmpl )
 {
-    const char *ptr;
-    char *p;
-    int i;
+    t_variant v = *tmpl;
+    char buffer[MAXPATH+1];
+    char *sizes;
+    char *ptr;
+    char *next;
+    const char *rname = lookup_renderer;
+    const char *wname = lookup_writer;
+    int val;
 
-    if ( !font || !filename || size<2 )
+    strncpy(buffer,spec,MAXPATH);
+    buffer[MAXPATH]='\0';
+    sizes = buffer;
+
+    // split "sizes@dpi:renderer:writer"
+    ptr = strchr(buffer,':');
+    if ( ptr )
     {
-	fprintf(stderr,"error: prepare_font_creation: illegal parameters\n");
-	return false;
+	*ptr++ = '\0';
+	rname = ptr;
+	ptr = strchr(ptr,':');
+	if ( ptr )
+	{
+	    *ptr++ = '\0';
+	    wname = ptr;
+	}
     }
-    ptr = strrchr(filename,'/');	// find last slash of path
+    ptr = strchr(sizes,'@');
     if ( ptr )
-        ptr++;				// and strip it
-    else
-        ptr = filename;			// else no path is given
-
-    // copy plain name of the file as font name and strip some chars.
-    strncpy(font->name,ptr,sizeof(font->name)-1);
-    p = strrchr(font->name,'.');	// Find last period (file ext)
-    if ( p )
-	*p = '\0';
-    for ( i=0; font->name[i]; i++ )
     {
-        if ( isspace(font->name[i]) || ispunct(font->name[i]) )
-            font->name[i] = '_';
+	*ptr++ = '\0';
+	v.dpi = strtol(ptr,&next,10);
+	if ( next==ptr || v.dpi<=0 )
+	{
+	    fprintf(stderr,"error: invalid dpi in variant spec '%s'\n",spec);
+	    return false;
+	}
+	v.hdpi = 0;
+	if ( *next=='x' )
+	{
+	    ptr = next+1;
+	    v.hdpi = strtol(ptr,&next,10);
+	    if ( next==ptr || v.hdpi<=0 )
+	    {
+		fprintf(stderr,"error: invalid hdpi in variant spec '%s'\n",spec);
+		return false;
+	    }
+	}
+	if ( *next!='\0' )
+	{
+	    fprintf(stderr,"error: invalid dpi in variant spec '%s'\n",spec);
+	    return false;
+	}
+    }
+
+    ptr = sizes;
+    do
+    {
+	val = strtol(ptr,&next,10);
+	if ( next==ptr || val<=0 || (*next!=',' && *next!='\0') )
+	{
+	    fprintf(stderr,"error: invalid size in variant spec '%s'\n",spec);
+	    return false;
+	}
+	v.pt_size = val;
+	if ( !add_variant(&v,rname,wname) )
+	    return false;
+	if ( flag_verbose )
+	    fprintf(stderr,"info: add variant %d pt @%dx%d renderer '%s' writer '%s'\n",
+		    val,v.dpi,v.hdpi?v.hdpi:v.dpi,rname,wname);
+	ptr = next+1;
+    } while ( *next==',' );
+    return true;
+}
+
+/* Add a target of the manifest as variant.
+ */
+static bool add_manifest_target ( const t_manifest_target *target )
+{
+    t_variant v;
+    bool result;
+
+    v.font_file = add_font_file(target->font);
+    if ( v.font_file < 0 )
+	return false;
+    v.pt_size = target->pt_size;
+    v.dpi = target->dpi;
+    v.hdpi = target->hdpi;
+    charset_init(&v.chars);
+    if ( !init_char_set(&v.chars,target->chars,target->subset,target->from,target->to) )
+	return false;
+    v.origin = target->origin;
+    v.calc_baseline = target->calc;
+    v.target = target->target;
+    if ( !init_render_options(&v.options,target->thresholds[0]?target->thresholds:DEFAULT_THRESHOLDS,target->gamma,target->rotation,target->packing) )
+	return false;
+    v.options.compression = target->compression;
+    v.options.dedup = target->dedup;
+    strncpy(v.options.arch,target->arch[0]?target->arch:DEFAULT_ARCH,MAXNAME);
+    v.options.arch[MAXNAME]='\0';
+    strncpy(v.options.section,target->section[0]?target->section:DEFAULT_SECTION,MAXNAME);
+    v.options.section[MAXNAME]='\0';
+    strncpy(v.output,target->output,MAXPATH);
+    v.output[MAXPATH]='\0';
+    v.unique_name = false;
+    result = add_variant(&v,target->renderer,target->writer);
+    charset_free(&v.chars);
+    return result;
+}
+
+/* Parse the comma separated gray \c thresholds into \c opt. The thresholds
+ * must be ascending values of 1..255. The gamma table is created here, so
+ * the renderers only have to look up the corrected coverage. A gamma above
+ * 1 makes the partly covered pixels darker. \c rotation must be a multiple
+ * of 90 degrees below 360. \c packing is the alignment of packed glyphs in
+ * bytes (1, 2 or 4), 0 disables the packing.
+ */
+static bool init_render_options ( t_render_options *opt, const char *thresholds, double gamma, int rotation, int packing )
+{
+    int *t = opt->thresholds;
+    char c;
+    int i;
+
+    if ( sscanf(thresholds,"%d,%d,%d%c",&t[0],&t[1],&t[2],&c)!=3 ||
+	 t[0]<1 || t[0]>=t[1] || t[1]>=t[2] || t[2]>255 )
+    {
+	fprintf(stderr,"error: invalid gray thresholds '%s'\n",thresholds);
+	return false;
+    }
+    if ( gamma<MIN_GAMMA || gamma>MAX_GAMMA )
+    {
+	fprintf(stderr,"error: invalid gamma %g\n",gamma);
+	return false;
+    }
+    if ( rotation!=0 && rotation!=90 && rotation!=180 && rotation!=270 )
+    {
+	fprintf(stderr,"error: invalid rotation %d\n",rotation);
+	return false;
+    }
+    if ( packing!=0 && packing!=1 && packing!=2 && packing!=4 )
+    {
+	fprintf(stderr,"error: invalid glyph alignment %d\n",packing);
+	return false;
+    }
+    opt->rotation = rotation;
+    opt->packing = packing;
+    opt->gamma = gamma;
+    for ( i=0; i<256; i++ )
+	opt->gamma_lut[i] = (uint8_t)(255.0*pow(i/255.0,1.0/gamma)+0.5);
+    return true;
+}
+
+/* Fill \c set with the code points of \c spec and the ones used by the text
+ * \c files. If both are empty, the range \c from..to is used.
+ */
+static bool init_char_set ( t_char_set *set, const char *spec, const char *files, int from, int to )
+{
+    if ( !spec[0] && !files[0] )
+	return charset_add(set,from,to);
+    if ( spec[0] && !charset_parse(set,spec) )
+	return false;
+    if ( files[0] && !charset_scan_files(set,files) )
+	return false;
+    if ( set->num == 0 )
+    {
+	fprintf(stderr,"error: no characters to render\n");
+	return false;
+    }
+    // the last glyph is never rendered, so a spare one follows the requested
+    charset_add_spare(set,1);
+    return true;
+}
+
+/* Combine all the functions to create the font. All font files are loaded
+ * only once. Variants which can share the captured glyphs are build as one
+ * group by the same thread. With more than one job, independent groups are
+ * build in parallel. The remaining jobs are used to rasterize the glyphs.
+ */
+static bool generate_font ( void )
+{
+    pthread_t *threads;
+    bool result = true;
+    int groups = 0;
+    int started = 0;
+    int num;
+    int i, j;
+
+    for ( i=0; i<num_fonts; i++ )
+    {
+	if ( !load_font_file(&fonts[i]) )
+	{
+	    release_font_files();
+	    return false;
+	}
+    }
+    if ( glyph_cache[0] && !cache_open(glyph_cache) )
+    {
+	release_font_files();
+	return false;
+    }
+
+    for ( i=0; i<num_variants; i++ )
+    {
+	for ( j=0; j<i && !same_capture(&variants[i],&variants[j]); j++ )
+	    ;
+	if ( j == i )
+	    groups++;
+    }
+    num = (jobs < groups) ? jobs : groups;
+    if ( num < 1 )
+	num = 1;
+    capture_jobs = jobs / num;
+    if ( flag_verbose && num > 1 )
+	fprintf(stderr,"info: build %d variants in %d groups with %d threads...\n",num_variants,groups,num);
+
+    threads = NULL;
+    if ( num > 1 )
+    {
+	threads = malloc(num*sizeof(pthread_t));
+	if ( !threads )
+	{
+	    fprintf(stderr,"error: generate_font: memory allocation failed\n");
+	    cache_close();
+	    release_font_files();
+	    return false;
+	}
+	for ( i=0; i<num; i++ )
+	{
+	    if ( pthread_create(&threads[started],NULL,build_worker,NULL) == 0 )
+		started++;
+	    else
+		fprintf(stderr,"error: generate_font: unable to start build thread %d\n",i);
+	}
+    }
+    if ( started == 0 )
+	build_worker(NULL);		// no threads, do it ourself
+    for ( i=0; i<started; i++ )
+	pthread_join(threads[i],NULL);
+    free(threads);
+
+    for ( i=0; i<num_variants; i++ )
+    {
+	if ( !variants[i].result )
+	    result = false;
+    }
+    if ( !cache_close() )
+	result = false;
+    release_font_files();
+    return result;
+}
+
+/* Check if the variants \c a and \c b can share the captured glyphs.
+ */
+static bool same_capture ( const t_variant *a, const t_variant *b )
+{
+    return a->font_file==b->font_file &&
+	   a->pt_size==b->pt_size &&
+	   a->dpi==b->dpi &&
+	   a->hdpi==b->hdpi &&
+	   a->origin==b->origin &&
+	   a->target.width==b->target.width &&
+	   a->target.height==b->target.height &&
+	   a->renderer->gray==b->renderer->gray &&
+	   charset_equal(&a->chars,&b->chars);
+}
+
+/* Thread function of a build thread. It takes the next unclaimed variant
+ * together with all following variants sharing the captured glyphs and builds
+ * them. The FreeType library and the faces of the thread are reused for all
+ * variants.
+ */
+static void *build_worker ( void *arg )
+{
+    t_rasterizer r;
+    t_variant *shared;
+    t_variant *v;
+    int i, j;
+
+    (void)arg;
+    if ( !init_rasterizer(&r) )
+	return NULL;
+    for (;;)
+    {
+	pthread_mutex_lock(&build_lock);
+	for ( i=0; i<num_variants && variants[i].claimed; i++ )
+	    ;
+	for ( j=i; j<num_variants; j++ )
+	{
+	    if ( !variants[j].claimed && same_capture(&variants[i],&variants[j]) )
+		variants[j].claimed = true;
+	}
+	pthread_mutex_unlock(&build_lock);
+	if ( i >= num_variants )
+	    break;
+
+	/* The first variant of the group which needs the glyphs captures
+	 * them. All following variants reuse them.
+	 */
+	shared = NULL;
+	for ( j=i; j<num_variants; j++ )
+	{
+	    v = &variants[j];
+	    if ( !same_capture(&variants[i],v) )
+		continue;
+	    if ( shared )
+	    {
+		v->pt_size = shared->pt_size;	// maybe searched
+		v->dpi = shared->dpi;
+		v->hdpi = shared->hdpi;
+		v->font = shared->font;
+		v->captured = shared->captured;
+		v->capture = shared->capture;
+	    }
+	    v->result = generate_variant(&r,v);
+	    if ( !shared && v->captured )
+		shared = v;
+	    else if ( shared != v )
+	    {
+		v->captured = NULL;
+		charset_init(&v->capture);
+	    }
+	}
+	if ( shared )
+	{
+	    free_glyph_matrices(shared->captured,shared->capture.num);
+	    shared->captured = NULL;
+	    charset_free(&shared->capture);
+	}
+    }
+    done_rasterizer(&r);
+    return NULL;
+}
+
+/* Create one variant of the font. If the glyphs are not captured yet (by a
+ * previous variant of the same group), they are rasterized here.
+ *
+ * If the files of a previous run are created from the same inputs, nothing
+ * is done. With an explicit output name this is checked before any glyph is
+ * rasterized. Otherwise the writer needs the metrics to build the name.
+ */
+static bool generate_variant ( t_rasterizer *r, t_variant *v )
+{
+    t_font_definition defs;
+    t_glyph_matrix *gmatrices;
+    char basename[MAXPATH+1];
+    const char *outname;
+    uint64_t hash;
+    FT_Face fc;
+    bool checked;
+    bool result;
+
+    if ( !v->captured && v->target.width && !solve_target_matrix(r,v) )
+	return false;
+    if ( !v->captured &&
+         !prepare_font_creation(&v->font,fonts[v->font_file].filename,v->pt_size,v->dpi,v->hdpi,v->origin) )
+	return false;
+
+    /* In batch mode, the variants need unique output names.
+     */
+    if ( v->unique_name )
+    {
+	snprintf(basename,MAXPATH,"%s_%d_%dx%d_%s",
+		 v->output[0]?v->output:v->font.name,
+		 v->pt_size,v->dpi,v->hdpi?v->hdpi:v->dpi,
+		 v->renderer_name);
+	basename[MAXPATH]='\0';
+	outname = basename;
+    }
+    else
+	outname = v->output;
+    hash = variant_hash(v,outname);
+    checked = (outname[0] && !v->captured);
+    if ( checked && is_uptodate(v,outname,hash) )
+	return true;
+
+    if ( !v->captured )
+    {
+	fc = get_face(r,v->font_file);
+	if ( !fc )
+	    return false;
+
+	/* Every glyph is rasterized only once. The captured set covers the
+	 * characters scanned for the metrics (#1..#254) and the requested set.
+	 * The matrices of the requested set are positioned afterwards, since
+	 * this needs the final metrics.
+	 */
+	charset_init(&v->capture);
+	if ( !charset_add(&v->capture,1,254) ||
+	     (!flag_check_only && !charset_merge(&v->capture,&v->chars)) )
+	{
+	    charset_free(&v->capture);
+	    return false;
+	}
+	v->captured = capture_glyph_matrices(fc,&fonts[v->font_file],&v->font,&v->capture,
+					     v->renderer->gray?GRAY_LOAD_FLAGS:GLYPH_LOAD_FLAGS);
+	if ( !v->captured )
+	{
+	    charset_free(&v->capture);
+	    return false;
+	}
+	if ( !check_font_metrics(fc,v) )
+	    return false;
+	if ( v->target.width &&
+	     (v->font.matrix.width>v->target.width || v->font.matrix.height>v->target.height) )
+	    fprintf(stderr,"warn: matrix %dx%d exceeds the target %dx%d\n",
+		    v->font.matrix.width,v->font.matrix.height,v->target.width,v->target.height);
+    }
+
+    if ( flag_check_only )		// if we only check the metrics,
+	return true;
+    if ( v->font.baseline > 0 )
+    {
+	fprintf(stderr,"error: illegal baseline! Must be less than 0! (%d)\n",v->font.baseline);
+	return false;
+    }
+
+    if ( !v->renderer || !v->num_writers )
+    {
+        fprintf(stderr,"fatal: bad setup of renderer/writer \n");
+        return false;
+    }
+
+    if ( v->calc_baseline )
+	v->font.baseline = v->font.calculated_baseline;
+    else
+	v->font.baseline = v->font.detected_baseline;
+    if ( !checked && is_uptodate(v,outname,hash) )
+	return true;
+
+    gmatrices = create_glyph_matrices(v);
+    if ( !gmatrices )
+	return false;
+    memset(&defs,0,sizeof(defs));
+    defs.options = &v->options;
+    result = v->renderer->init(&defs,&v->font,&v->chars);
+    if ( result )
+    {
+	defs.hash = hash;
+	result = v->renderer->generate(&defs,gmatrices);
+	if ( result )
+	    result = dedup_glyphs(&defs);
+	if ( result )
+	    result = compress_glyphs(&defs);
+	if ( result )
+	    result = run_writers(v,&defs,outname);
+	release_compressed(&defs);
+	release_glyph_map(&defs);
+	v->renderer->done(&defs);
+    }
+    free(gmatrices);
+    return result;
+}
+
+
+/* Hand the rendered font \c defs to all writers of the variant \c v. With
+ * more than one writer, each one runs in its own thread.
+ */
+static bool run_writers ( t_variant *v, t_font_definition *defs, const char *outname )
+{
+    t_writer_job jobs[MAXWRITERS];
+    bool failed = false;
+    int idx;
+
+    for ( idx=0; idx<v->num_writers; idx++ )
+    {
+	jobs[idx].writer = v->writer[idx];
+	jobs[idx].lock = &writer_lock[writer[v->writer_index[idx]].lock];
+	jobs[idx].defs = defs;
+	jobs[idx].outname = outname;
+	jobs[idx].result = false;
+    }
+    if ( v->num_writers == 1 )
+    {
+	writer_worker(&jobs[0]);
+	return jobs[0].result;
+    }
+
+    for ( idx=0; idx<v->num_writers; idx++ )
+    {
+	jobs[idx].started = (pthread_create(&jobs[idx].thread,NULL,writer_worker,&jobs[idx]) == 0);
+	if ( !jobs[idx].started )
+	{
+	    fprintf(stderr,"error: run_writers: unable to start writer %d\n",idx);
+	    failed = true;
+	}
+    }
+    for ( idx=0; idx<v->num_writers; idx++ )
+    {
+	if ( jobs[idx].started )
+	    pthread_join(jobs[idx].thread,NULL);
+	if ( !jobs[idx].result )
+	    failed = true;
+    }
+    return !failed;
+}
+
+/* Thread function of a single writer. The writer keeps its state in static
+ * variables, so its lock is held until all files are written. After a
+ * successful init(), done() is called even if create() failed, so the files
+ * of the writer are closed before the next variant uses it.
+ */
+static void *writer_worker ( void *arg )
+{
+    t_writer_job *job = (t_writer_job*)arg;
+
+    pthread_mutex_lock(job->lock);
+    job->result = job->writer->init(job->defs,job->outname);
+    if ( job->result )
+    {
+	job->result = job->writer->create(job->defs);
+	if ( !job->writer->done(job->defs) )
+	    job->result = false;
+    }
+    pthread_mutex_unlock(job->lock);
+    return NULL;
+}
+
+
+/* Prepare the font generation. This includes the initialisation of \c font.
+ * Sone variables are set based on the commandline options.
+ */
+static bool prepare_font_creation ( t_font_metrics *font, const char *filename, int size, int dpi, int hdpi, int preset_origin )
+{
+    const char *ptr;
+    char *p;
+    int i;
+
+    if ( !font || !filename || size<2 )
+    {
+	fprintf(stderr,"error: prepare_font_creation: illegal parameters\n");
+	return false;
+    }
+    ptr = strrchr(filename,'/');	// find last slash of path
+    if ( ptr )
+        ptr++;				// and strip it
+    else
+        ptr = filename;			// else no path is given
+
+    // copy plain name of the file as font name and strip some chars.
+    strncpy(font->name,ptr,sizeof(font->name)-1);
+    p = strrchr(font->name,'.');	// Find last period (file ext)
+    if ( p )
+	*p = '\0';
+    for ( i=0; font->name[i]; i++ )
+    {
+        if ( isspace(font->name[i]) || ispunct(font->name[i]) )
+            font->name[i] = '_';
     }
     if ( flag_verbose )
 	fprintf(stderr,"info: use font name '%s'\n",font->name);
@@ -603,83 +1769,744 @@ static bool prepare_font_creation ( t_font_metrics *font, const char *filename,
     return true;
 }
 
-/* Try to load a font and calculate the needed metrics. The results are passed
- * back in \c fonts.
+/* Search the size and the dpi values of the variant \c v to get the largest
+ * matrix fitting into \c v->target. The matrix height depends on the highest
+ * and the lowest glyphs of #1..#254 and the line height, the width on the
+ * advance of "M" (see check_font_metrics()). These glyphs are selected once
+ * from the unscaled outlines, so each probe rasterizes only a few glyphs.
+ *
+ * The hinting can change the proportions of single glyphs, so the result is
+ * checked with all glyphs at last. If a glyph exceeds the target, it is added
+ * to the probed ones and the search is repeated. The glyphs are rasterized
+ * like the renderer of \c v does it, so a gray renderer probes gray bitmaps.
+ */
+static bool solve_target_matrix ( t_rasterizer *r, t_variant *v )
+{
+    int codes[2*NUM_EXTREMES+1+2*MAX_SEARCHES];
+    int all[254];
+    t_pixel_size m;
+    FT_Face fc;
+    int highest, lowest;
+    int load_flags;
+    int dpi;
+    int num;
+    int i;
+
+    dpi = v->dpi;
+    load_flags = v->renderer->gray ? GRAY_LOAD_FLAGS : GLYPH_LOAD_FLAGS;
+    fc = get_face(r,v->font_file);
+    if ( !fc )
+	return false;
+    num = find_extreme_glyphs(fc,codes);
+    all[0] = 'M';
+    for ( i=1; i<254; i++ )
+	all[i] = (i<'M') ? i : i+1;
+    for ( i=0; i<MAX_SEARCHES; i++ )
+    {
+	v->dpi = dpi;
+	if ( !search_target_matrix(fc,codes,num,load_flags,v) ||
+	     !probe_matrix(fc,all,254,load_flags,v->pt_size,v->dpi,v->hdpi,&m,&highest,&lowest) )
+	    return false;
+	if ( m.width<=v->target.width && m.height<=v->target.height )
+	    break;
+	codes[num++] = highest;
+	if ( lowest != highest )
+	    codes[num++] = lowest;
+    }
+    if ( flag_verbose )
+	fprintf(stderr,"info: target matrix %dx%d: size %d pt, dpi %d x %d (%dx%d)\n",
+		v->target.width,v->target.height,v->pt_size,v->hdpi?v->hdpi:v->dpi,v->dpi,m.width,m.height);
+    return true;
+}
+
+/* Search with the glyphs \c codes. First the largest point size fitting the
+ * height is searched with \c v->dpi. Then the vertical dpi is increased as
+ * far as possible for this size. At last the horizontal dpi is searched to
+ * fit the width. The result is stored in \c v.
+ */
+static bool search_target_matrix ( FT_Face fc, const int *codes, int num, int load_flags, t_variant *v )
+{
+    t_pixel_size m;
+    int size;
+    int dpi;
+    int hdpi;
+    int lo, hi, mid;
+
+    dpi = v->dpi;
+    // the largest size fitting the height
+    if ( !probe_matrix(fc,codes,num,load_flags,2,dpi,0,&m,NULL,NULL) )
+	return false;
+    if ( m.height > v->target.height )
+    {
+	fprintf(stderr,"error: matrix height %d not reachable with %d dpi\n",v->target.height,dpi);
+	return false;
+    }
+    lo = 2;
+    hi = 4;
+    while ( hi<=MAX_PT_SIZE && probe_matrix(fc,codes,num,load_flags,hi,dpi,0,&m,NULL,NULL) && m.height<=v->target.height )
+    {
+	lo = hi;
+	hi *= 2;
+    }
+    while ( hi-lo > 1 )
+    {
+	mid = (lo+hi)/2;
+	if ( probe_matrix(fc,codes,num,load_flags,mid,dpi,0,&m,NULL,NULL) && m.height<=v->target.height )
+	    lo = mid;
+	else
+	    hi = mid;
+    }
+    size = lo;
+
+    // the largest vertical dpi for this size. size+1 doesn't fit.
+    lo = dpi;
+    hi = (dpi*(size+1))/size + 1;
+    while ( hi-lo > 1 )
+    {
+	mid = (lo+hi)/2;
+	if ( probe_matrix(fc,codes,num,load_flags,size,mid,0,&m,NULL,NULL) && m.height<=v->target.height )
+	    lo = mid;
+	else
+	    hi = mid;
+    }
+    dpi = lo;
+
+    // the largest horizontal dpi fitting the width
+    for (;;)
+    {
+	// find hdpi values around the width, starting with the vertical dpi
+	lo = hi = dpi;
+	if ( probe_matrix(fc,codes,num,load_flags,size,dpi,dpi,&m,NULL,NULL) && m.width<=v->target.width )
+	{
+	    do
+		hi *= 2;
+	    while ( hi<=16*dpi && probe_matrix(fc,codes,num,load_flags,size,dpi,hi,&m,NULL,NULL) && m.width<=v->target.width );
+	}
+	else
+	{
+	    do
+		lo /= 2;
+	    while ( lo>0 && (!probe_matrix(fc,codes,num,load_flags,size,dpi,lo,&m,NULL,NULL) || m.width>v->target.width) );
+	    if ( lo == 0 )
+	    {
+		fprintf(stderr,"error: matrix width %d not reachable\n",v->target.width);
+		return false;
+	    }
+	}
+	while ( hi-lo > 1 )
+	{
+	    mid = (lo+hi)/2;
+	    if ( probe_matrix(fc,codes,num,load_flags,size,dpi,mid,&m,NULL,NULL) && m.width<=v->target.width )
+		lo = mid;
+	    else
+		hi = mid;
+	}
+	hdpi = lo;
+	// the hinting may change the height a little
+	if ( !probe_matrix(fc,codes,num,load_flags,size,dpi,hdpi,&m,NULL,NULL) )
+	    return false;
+	if ( m.height<=v->target.height || size<=2 )
+	    break;
+	size--;
+    }
+
+    v->pt_size = size;
+    v->hdpi = (hdpi==dpi) ? 0 : hdpi;
+    v->dpi = dpi;
+    return true;
+}
+
+/* Select the glyphs which define the size of the matrix: "M" and the highest
+ * and lowest glyphs of #1..#254. The glyphs are compared by their unscaled
+ * outlines, so nothing is rasterized here. Returns the number of \c codes.
+ */
+static int find_extreme_glyphs ( FT_Face fc, int *codes )
+{
+    int high[NUM_EXTREMES];		// codes sorted by top (descending)
+    int low[NUM_EXTREMES];		// codes sorted by bottom (ascending)
+    FT_Pos top[NUM_EXTREMES];
+    FT_Pos bottom[NUM_EXTREMES];
+    FT_Pos t, b;
+    int num = 0;
+    int ch;
+    int i, j;
+
+    for ( i=0; i<NUM_EXTREMES; i++ )
+	high[i] = low[i] = 0;
+    for ( ch=1; ch<255; ch++ )
+    {
+	if ( FT_Load_Char(fc,ch,FT_LOAD_NO_SCALE) )
+	    continue;
+	t = fc->glyph->metrics.horiBearingY;
+	b = t - fc->glyph->metrics.height;
+	for ( i=0; i<NUM_EXTREMES && high[i] && top[i]>=t; i++ )
+	    ;
+	if ( i < NUM_EXTREMES )
+	{
+	    memmove(&high[i+1],&high[i],(NUM_EXTREMES-i-1)*sizeof(int));
+	    memmove(&top[i+1],&top[i],(NUM_EXTREMES-i-1)*sizeof(FT_Pos));
+	    high[i] = ch;
+	    top[i] = t;
+	}
+	for ( i=0; i<NUM_EXTREMES && low[i] && bottom[i]<=b; i++ )
+	    ;
+	if ( i < NUM_EXTREMES )
+	{
+	    memmove(&low[i+1],&low[i],(NUM_EXTREMES-i-1)*sizeof(int));
+	    memmove(&bottom[i+1],&bottom[i],(NUM_EXTREMES-i-1)*sizeof(FT_Pos));
+	    low[i] = ch;
+	    bottom[i] = b;
+	}
+    }
+
+    codes[num++] = 'M';
+    for ( i=0; i<2*NUM_EXTREMES; i++ )
+    {
+	ch = (i<NUM_EXTREMES) ? high[i] : low[i-NUM_EXTREMES];
+	for ( j=0; j<num && codes[j]!=ch; j++ )
+	    ;
+	if ( ch && j==num )
+	    codes[num++] = ch;
+    }
+    return num;
+}
+
+/* Rasterize the glyphs \c codes with the passed size and dpi values and the
+ * FreeType \c load_flags and calculate the matrix like check_font_metrics()
+ * does. \c codes[0] must be "M". If passed, \c highest and \c lowest return
+ * the glyphs with the max. ascent and descent.
  */
-static bool check_font_metrics ( t_font_metrics *font )
+static bool probe_matrix ( FT_Face fc, const int *codes, int num, int load_flags, int size, int dpi, int hdpi, t_pixel_size *matrix, int *highest, int *lowest )
 {
     FT_Glyph glyph;
-    FT_BitmapGlyphRec *g;	// little helper
     FT_Bitmap *bitmap;
-    int regular_height;
+    int max_ascent = 0;
+    int max_descent = 0;
     int ascent;
     int descent;
+    int top;
     int i;
 
-    if ( !font )
+    if ( FT_Set_Char_Size(fc,0,size<<6,hdpi,dpi) )
+	return false;
+    matrix->height = (int)(fc->size->metrics.height)>>6;
+    for ( i=0; i<num; i++ )
     {
-	fprintf(stderr,"error: prepare_font_creation: illegal parameters\n");
+	if ( !create_glyph(fc,&glyph,codes[i],load_flags) )
+	    return false;
+	if ( i == 0 )
+	    matrix->width = (int)(fc->glyph->advance.x)>>6;
+	bitmap = &fc->glyph->bitmap;
+	top = fc->glyph->bitmap_top;
+	descent = max(0,(int)bitmap->rows - top);
+	ascent = max(0, max(top,(int)bitmap->rows) - descent);
+	if ( descent > max_descent || i==0 )
+	{
+	    max_descent = descent;
+	    if ( lowest )
+		*lowest = codes[i];
+	}
+	if ( ascent > max_ascent || i==0 )
+	{
+	    max_ascent = ascent;
+	    if ( highest )
+		*highest = codes[i];
+	}
+	FT_Done_Glyph(glyph);
+    }
+    if ( max_ascent+max_descent > matrix->height )
+	matrix->height = max_ascent+max_descent;
+    return true;
+}
+
+/* Add \c len bytes of \c data to the FNV-1a \c hash.
+ */
+static uint64_t hash_bytes ( uint64_t hash, const void *data, size_t len )
+{
+    const uint8_t *p = (const uint8_t*)data;
+
+    while ( len-- )
+    {
+	hash ^= *p++;
+	hash *= HASH_PRIME;
+    }
+    return hash;
+}
+
+/* Calculate the hash of all inputs of the variant \c v: the content of the
+ * font file, the options which affect the metrics and the output, the names
+ * of the plugins and the version of the generator.
+ */
+static uint64_t variant_hash ( const t_variant *v, const char *outname )
+{
+    char buffer[3*MAXPATH+1];
+    uint64_t hash;
+
+    snprintf(buffer,3*MAXPATH,"%s|%s|%d|%d|%d|%d|%d|%s|%s|%s|%d,%d,%d|%g|%d|%d|%d|%d|%s|%s",
+	     PACKAGE_STRING,v->font.name,
+	     v->pt_size,v->dpi,v->hdpi,
+	     v->origin,v->calc_baseline,
+	     v->renderer_name,v->writer_name,outname,
+	     v->options.thresholds[0],v->options.thresholds[1],v->options.thresholds[2],
+	     v->options.gamma,v->options.rotation,v->options.packing,v->options.compression,
+	     v->options.dedup,v->options.arch,v->options.section);
+    buffer[3*MAXPATH]='\0';
+    hash = hash_bytes(fonts[v->font_file].hash,buffer,strlen(buffer));
+    hash = hash_bytes(hash,v->chars.ranges,v->chars.num_ranges*sizeof(t_char_range));
+    if ( v->chars.spare )
+	hash = hash_bytes(hash,&v->chars.spare,sizeof(v->chars.spare));
+    return hash;
+}
+
+/* Ask the writers of the variant \c v if their files are already created
+ * from the inputs described by \c hash. If one of them is outdated, all
+ * writers have to run.
+ */
+static bool is_uptodate ( t_variant *v, const char *outname, uint64_t hash )
+{
+    t_font_definition defs;
+    bool result = true;
+    int idx;
+
+    if ( flag_force || flag_check_only )
+	return false;
+    memset(&defs,0,sizeof(defs));
+    defs.metrics = &v->font;
+    defs.hash = hash;
+    for ( idx=0; result && idx<v->num_writers; idx++ )
+    {
+	if ( !v->writer[idx]->uptodate )
+	    return false;
+	pthread_mutex_lock(&writer_lock[writer[v->writer_index[idx]].lock]);
+	result = v->writer[idx]->uptodate(&defs,outname);
+	pthread_mutex_unlock(&writer_lock[writer[v->writer_index[idx]].lock]);
+    }
+    if ( result && flag_verbose )
+	fprintf(stderr,"info: %d pt %s/%s is up to date\n",v->pt_size,v->renderer_name,v->writer_name);
+    return result;
+}
+
+/* Make the font file available in memory. The file is mapped read-only, so
+ * large fonts are neither copied nor read by FreeType's own stream handling.
+ * The same bytes are used by all faces of the file, regardless of the thread
+ * which uses them. If mmap() is not available or fails, the file is read
+ * into a buffer instead.
+ */
+static bool load_font_file ( t_font_file *ff )
+{
+    struct stat st;
+    int fd;
+
+    fd = open(ff->filename,O_RDONLY);
+    if ( fd < 0 )
+    {
+	fprintf(stderr,"error: load_font_file: unable to open '%s'\n",ff->filename);
+	return false;
+    }
+    if ( fstat(fd,&st)!=0 || st.st_size<=0 )
+    {
+	fprintf(stderr,"error: load_font_file: unable to get size of '%s'\n",ff->filename);
+	close(fd);
+	return false;
+    }
+    ff->size = st.st_size;
+#ifdef HAVE_MMAP
+    ff->data = mmap(NULL,ff->size,PROT_READ,MAP_PRIVATE,fd,0);
+    if ( ff->data != MAP_FAILED )
+    {
+	ff->mapped = true;
+	close(fd);
+	ff->hash = hash_bytes(HASH_INIT,ff->data,ff->size);
+	if ( flag_verbose )
+	    fprintf(stderr,"info: mapped %ld bytes of font data\n",(long)ff->size);
+	return true;
+    }
+    if ( flag_verbose )
+	fprintf(stderr,"info: load_font_file: mmap failed, read the file\n");
+#endif
+    ff->mapped = false;
+    ff->data = malloc(ff->size);
+    if ( !ff->data )
+    {
+	fprintf(stderr,"error: load_font_file: memory allocation failed\n");
+	close(fd);
+	return false;
+    }
+    if ( read(fd,ff->data,ff->size) != ff->size )
+    {
+	fprintf(stderr,"error: load_font_file: unable to read '%s'\n",ff->filename);
+	free(ff->data);
+	ff->data = NULL;
+	close(fd);
 	return false;
     }
+    close(fd);
+    ff->hash = hash_bytes(HASH_INIT,ff->data,ff->size);
+    if ( flag_verbose )
+	fprintf(stderr,"info: loaded %ld bytes of font data\n",(long)ff->size);
+    return true;
+}
+
+/* Release the data of all font files. The data must be valid as long as a
+ * face uses it.
+ */
+static void release_font_files ( void )
+{
+    int i;
+
+    for ( i=0; i<num_fonts; i++ )
+    {
+	if ( !fonts[i].data )
+	    continue;
+#ifdef HAVE_MMAP
+	if ( fonts[i].mapped )
+	    munmap(fonts[i].data,fonts[i].size);
+	else
+#endif
+	    free(fonts[i].data);
+	fonts[i].data = NULL;
+	fonts[i].size = 0;
+    }
+}
+
+static bool init_rasterizer ( t_rasterizer *r )
+{
+    int err;
+    int i;
+
+    err = FT_Init_FreeType(&r->library);
+    if ( err )
+    {
+        fprintf(stderr,"error: init FreeType failed (%d)\n",err);
+        return false;
+    }
+    for ( i=0; i<MAXFONTS; i++ )
+	r->face[i] = NULL;
+    return true;
+}
+
+/* Return the face of the font file \c font_file. The face is created on the
+ * first call.
+ */
+static FT_Face get_face ( t_rasterizer *r, int font_file )
+{
+    int err;
+
+    if ( !r->face[font_file] )
+    {
+	err = FT_New_Memory_Face(r->library,fonts[font_file].data,fonts[font_file].size,0,&r->face[font_file]);
+	if ( err )
+	{
+	    fprintf(stderr,"error: create of FreeType face failed (%d)\n",err);
+	    r->face[font_file] = NULL;
+	}
+    }
+    return r->face[font_file];
+}
+
+/* Free the FreeType library of the thread (including all faces).
+ */
+static void done_rasterizer ( t_rasterizer *r )
+{
+    FT_Done_FreeType(r->library);
+}
+
+/* Rasterize all characters of \c chars with the face \c fc and capture the
+ * glyph bitmaps. \c load_flags selects monochrome or gray bitmaps. The result
+ * is indexed by the glyph index of the character inside \c chars and is used
+ * for both, the metrics scan and the rendering. The offsets into the char
+ * matrix are not known yet, so \c offset_y is left 0 here.
+ *
+ * Glyphs found in the glyph cache are taken from there. Only the missing
+ * ones are rasterized. If more than one job is available, the range is split
+ * into equal shards which are rasterized by worker threads. The workers create
+ * their own faces from the data of \c ff. Every worker writes only into its
+ * own slots of the array, so the order of the result is deterministic.
+ */
+static t_glyph_matrix *capture_glyph_matrices ( FT_Face fc, const t_font_file *ff, const t_font_metrics *font, const t_char_set *chars, int load_flags )
+{
+    t_capture_job *workers;
+    t_glyph_matrix *gmatrices;
+    t_cache_key key;
+    bool failed = false;
+    int missing;
+    int num;
+    int idx;
+    int n;
+
+    if ( !fc || !ff || !font || !chars )
+    {
+	fprintf(stderr,"error: capture_glyph_matrices: illegal parameters\n");
+	return NULL;
+    }
+    num = chars->num;
+    if ( num <= 0 )
+    {
+	fprintf(stderr,"error: capture_glyph_matrices: bad number of chars\n");
+	return NULL;
+    }
+    gmatrices = malloc(num*sizeof(t_glyph_matrix));
+    if ( !gmatrices )
+    {
+	fprintf(stderr,"error: capture_glyph_matrices: memory allocation failed\n");
+	return NULL;
+    }
+
+    /* Take all known glyphs from the cache. The missing ones are marked with
+     * a negative buffer size.
+     */
+    key.font_hash = ff->hash;
+    key.pt_size = font->pt_size;
+    key.dpi = font->dpi;
+    key.hdpi = font->hdpi;
+    key.load_flags = load_flags;
+    missing = 0;
+    for ( idx=0; idx<num; idx++ )
+    {
+	key.character = charset_code(chars,idx);
+	if ( !cache_lookup(&key,&gmatrices[idx]) )
+	{
+	    gmatrices[idx].sz_buffer = -1;
+	    gmatrices[idx].buffer = NULL;
+	    missing++;
+	}
+    }
 
     // the point size must be converted to '26dot6' fixed-point formast
-    FT_Set_Char_Size(face,0,(font->pt_size)<<6,font->hdpi,font->dpi);
+    FT_Set_Char_Size(fc,0,(font->pt_size)<<6,font->hdpi,font->dpi);
+    if ( missing == 0 )
+    {
+	if ( flag_verbose )
+	    fprintf(stderr,"info: took all %d glyphs from the cache\n",num);
+	return gmatrices;
+    }
 
-    if ( create_glyph(&glyph,'M') )
+    n = (capture_jobs < missing) ? capture_jobs : missing;
+    if ( n <= 1 )
     {
-	if ( glyph->format != FT_GLYPH_FORMAT_BITMAP )
+	for ( idx=0; idx<num; idx++ )
 	{
-	    FT_Done_Glyph(glyph);
-	    fprintf(stderr,"error: check_font_metrics: glyph not in BITMAP format!\n");
-	    return false;
+	    if ( gmatrices[idx].sz_buffer<0 && !capture_glyph(fc,&key,&gmatrices[idx],charset_code(chars,idx)) )
+	    {
+		free_glyph_matrices(gmatrices,num);
+		return NULL;
+	    }
 	}
-        //g = (FT_BitmapGlyphRec*)glyph;
-        bitmap = &face->glyph->bitmap;
-	font->absolute_height     = (int)(face->size->metrics.height)>>6;
-	font->matrix.height       = font->absolute_height;
-	// (jd) using the verAdvance value sometimes leads to characters bigger
-	//than the matrix height!
-	// font->matrix.height   = (int)(face->glyph->metrics.vertAdvance)>>6;
-	regular_height            = (int)(face->glyph->metrics.vertAdvance)>>6;
-	font->matrix.width        = (int)(face->glyph->metrics.horiAdvance)>>6;
-	font->calculated_baseline = ((int)(face->glyph->metrics.vertAdvance)>>6) - (font->absolute_height);
-	font->em.height           = bitmap->rows;
-	font->em.width            = bitmap->width;
-	FT_Done_Glyph(glyph);
+	return gmatrices;
     }
-    else
-	return false;
 
-    if ( create_glyph(&glyph,'x') )
+    workers = malloc(n*sizeof(t_capture_job));
+    if ( !workers )
+    {
+	fprintf(stderr,"error: capture_glyph_matrices: memory allocation failed\n");
+	free_glyph_matrices(gmatrices,num);
+	return NULL;
+    }
+    if ( flag_verbose )
+	fprintf(stderr,"info: rasterize %d glyphs with %d jobs...\n",missing,n);
+    for ( idx=0; idx<n; idx++ )
     {
-	if ( glyph->format != FT_GLYPH_FORMAT_BITMAP )
+	workers[idx].ff = ff;
+	workers[idx].font = font;
+	workers[idx].key = &key;
+	workers[idx].gmatrices = gmatrices;
+	workers[idx].chars = chars;
+	workers[idx].begin = (idx*num)/n;
+	workers[idx].end = ((idx+1)*num)/n;
+	workers[idx].result = false;
+	workers[idx].started = (pthread_create(&workers[idx].thread,NULL,capture_worker,&workers[idx]) == 0);
+	if ( !workers[idx].started )
 	{
-	    FT_Done_Glyph(glyph);
-	    fprintf(stderr,"error: check_font_metrics: glyph not in BITMAP format!\n");
-	    return false;
+	    fprintf(stderr,"error: capture_glyph_matrices: unable to start job %d\n",idx);
+	    failed = true;
 	}
-        bitmap = &face->glyph->bitmap;
-	font->ex.height = bitmap->rows;
-	font->ex.width  = bitmap->width;
-	FT_Done_Glyph(glyph);
     }
-    else
+    for ( idx=0; idx<n; idx++ )
+    {
+	if ( workers[idx].started )
+	    pthread_join(workers[idx].thread,NULL);
+	if ( !workers[idx].result )
+	    failed = true;
+    }
+    free(workers);
+
+    if ( failed )
+    {
+	free_glyph_matrices(gmatrices,num);
+	return NULL;
+    }
+    return gmatrices;
+}
+
+/* Thread function of a single job. It uses it's own FreeType library and
+ * face, created from the shared font data in memory, to rasterize the
+ * characters of its shard.
+ */
+static void *capture_worker ( void *arg )
+{
+    t_capture_job *job = (t_capture_job*)arg;
+    FT_Library lib;
+    FT_Face fc;
+    int idx;
+    int err;
+
+    err = FT_Init_FreeType(&lib);
+    if ( err )
+    {
+        fprintf(stderr,"error: capture_worker: init FreeType failed (%d)\n",err);
+        return NULL;
+    }
+    err = FT_New_Memory_Face(lib,job->ff->data,job->ff->size,0,&fc);
+    if ( err )
+    {
+        fprintf(stderr,"error: capture_worker: create of FreeType face failed (%d)\n",err);
+        FT_Done_FreeType(lib);
+        return NULL;
+    }
+    FT_Set_Char_Size(fc,0,(job->font->pt_size)<<6,job->font->hdpi,job->font->dpi);
+    job->result = true;
+    for ( idx=job->begin; idx<job->end; idx++ )
+    {
+	if ( job->gmatrices[idx].sz_buffer >= 0 )
+	    continue;			// taken from the cache
+	if ( !capture_glyph(fc,job->key,&job->gmatrices[idx],charset_code(job->chars,idx)) )
+	{
+	    job->result = false;
+	    break;
+	}
+    }
+    FT_Done_Face(fc);
+    FT_Done_FreeType(lib);
+    return NULL;
+}
+
+/* Rasterize a single \c character with the face \c fc and store the glyph
+ * bitmap and its metrics in \c gm. The glyph is passed to the glyph cache
+ * with the \c key of the face.
+ *
+ * NOTE: an empty glyph bitmap leads to a size of 0 and a buffer pointer of NULL!
+ */
+static bool capture_glyph ( FT_Face fc, const t_cache_key *key, t_glyph_matrix *gm, int character )
+{
+    t_cache_key k;
+    FT_Glyph glyph;
+    FT_BitmapGlyphRec *g;	// little helper
+    FT_Bitmap *bitmap;
+    uint8_t *p;
+
+    if ( !create_glyph(fc,&glyph,character,key->load_flags) )
 	return false;
-    if ( create_glyph(&glyph,'W') )
+    if ( glyph->format != FT_GLYPH_FORMAT_BITMAP )
     {
-	if ( glyph->format != FT_GLYPH_FORMAT_BITMAP )
+	FT_Done_Glyph(glyph);
+	fprintf(stderr,"error: capture_glyph: glyph not in BITMAP format!\n");
+	return false;
+    }
+    bitmap = &fc->glyph->bitmap;
+    g = (FT_BitmapGlyphRec*)glyph;
+#ifdef DEBUG
+    // should be the same.... just to be sure
+    if ( (int)(fc->glyph->bitmap_top) != (int)(g->top) )
+	fprintf(stderr,"capture_glyph: bitmap_top=%d differ from top=%d!\n",(int)(fc->glyph->bitmap_top),(int)(g->top));
+#endif
+    gm->width = bitmap->width;			// width of the glyph bitmap
+    gm->height = bitmap->rows;			// height of the glyph bitmap
+    gm->pitch = bitmap->pitch;			// no. of bytes per bitmap row
+    gm->advance = fc->glyph->advance.x;		// real width for proportional fonts
+    gm->vert_advance = fc->glyph->metrics.vertAdvance;
+    gm->top = g->top;
+    gm->offset_x = g->left;			// x offset into char matrix
+    gm->offset_y = 0;				// set by create_glyph_matrices
+
+    /* Calculate the size used by the glyph bitmap and allocate the
+     * buffer. Copy the bitmap buffer provided by the FreeType-library.
+     */
+    gm->sz_buffer = (bitmap->rows)*(bitmap->pitch);	// size of the buffer
+    if ( gm->sz_buffer )
+    {
+	p = malloc(gm->sz_buffer*sizeof(uint8_t));
+	if ( !p )
 	{
 	    FT_Done_Glyph(glyph);
-	    fprintf(stderr,"error: check_font_metrics: glyph not in BITMAP format!\n");
+	    fprintf(stderr,"error: capture_glyph: memory allocation failed\n");
 	    return false;
 	}
-        bitmap = &face->glyph->bitmap;
-	font->we.height = bitmap->rows;
-	font->we.width  = bitmap->width;
-	FT_Done_Glyph(glyph);
+	memcpy(p,bitmap->buffer,gm->sz_buffer);
     }
     else
+	p = NULL;
+    gm->buffer = p;
+#ifdef DEBUG_OFF
+    fprintf(stderr,"capture_glyph: width %d needs %d bytes. size=%d\n",bitmap->width,bitmap->pitch,gm->sz_buffer);
+#endif
+    FT_Done_Glyph(glyph);
+    k = *key;
+    k.character = character;
+    cache_store(&k,gm);
+    return true;
+}
+
+/* Free the \c num captured glyph matrices and the array itself.
+ */
+static void free_glyph_matrices ( t_glyph_matrix *gmatrices, int num )
+{
+    int idx;
+
+    if ( !gmatrices )
+	return;
+    for ( idx=0; idx<num; idx++ )
+    {
+	if ( gmatrices[idx].buffer )
+	    free(gmatrices[idx].buffer);
+    }
+    free(gmatrices);
+}
+
+/* Calculate the needed metrics of the variant \c v. The glyphs are not loaded
+ * again, all values are taken from the captured glyph matrices, which must
+ * cover the characters #1..#254. Only the line height is taken from the face
+ * \c fc. The results are passed back in \c v->font.
+ */
+static bool check_font_metrics ( FT_Face fc, t_variant *v )
+{
+    t_font_metrics *font;
+    const t_glyph_matrix *captured;
+    const t_glyph_matrix *gm;
+    int regular_height;
+    int ascent;
+    int descent;
+    int first;
+    int i;
+
+    if ( !fc || !v || !v->captured || charset_index(&v->capture,1)<0 )
+    {
+	fprintf(stderr,"error: check_font_metrics: illegal parameters\n");
 	return false;
+    }
+    font = &v->font;
+    captured = v->captured;
+    // #1..#254 are part of one range, so captured[ch-first] is used for them
+    first = 1 - charset_index(&v->capture,1);
+
+    gm = &captured['M'-first];
+    font->absolute_height     = (int)(fc->size->metrics.height)>>6;
+    font->matrix.height       = font->absolute_height;
+    // (jd) using the verAdvance value sometimes leads to characters bigger
+    //than the matrix height!
+    // font->matrix.height   = (gm->vert_advance)>>6;
+    regular_height            = (gm->vert_advance)>>6;
+    font->matrix.width        = (gm->advance)>>6;
+    font->calculated_baseline = ((gm->vert_advance)>>6) - (font->absolute_height);
+    font->em.height           = gm->height;
+    font->em.width            = gm->width;
+
+    gm = &captured['x'-first];
+    font->ex.height = gm->height;
+    font->ex.width  = gm->width;
+
+    gm = &captured['W'-first];
+    font->we.height = gm->height;
+    font->we.width  = gm->width;
 
     /* Scan the whole font to determine the correct values for the maximal
      * size of the glyphs. This is needed to get correct values for ascend and
@@ -691,33 +2518,15 @@ static bool check_font_metrics ( t_font_metrics *font )
     font->max_descent = 0;
     for ( i=1; i<255; i++ )
     {
-	if ( create_glyph(&glyph,i) )
-	{
-	    if ( glyph->format != FT_GLYPH_FORMAT_BITMAP )
-	    {
-		FT_Done_Glyph(glyph);
-		fprintf(stderr,"error: check_font_metrics: glyph not in BITMAP format!\n");
-		return false;
-	    }
-	    bitmap = &face->glyph->bitmap;
-	    g = (FT_BitmapGlyphRec*)glyph;
-#ifdef DEBUG
-	    // should be the same.... just to be sure
-	    if ( (int)(face->glyph->bitmap_top) != (int)(g->top) )
-		fprintf(stderr,"check_font_metrics: bitmap_top=% differ from top=%d!\n",(int)(face->glyph->bitmap_top),(int)(g->top));
-#endif
-	    // Detect the highest and lowest point. In the case the glyph has
-	    // no descender, the value must be 0!
-	    descent = max(0,face->glyph->bitmap.rows - g->top);
-	    ascent = max(0, max(g->top,face->glyph->bitmap.rows) - descent);
-	    if ( descent > font->max_descent )
-	      font->max_descent = descent;
-	    if ( ascent > font->max_ascent )
-	      font->max_ascent = ascent;
-	    FT_Done_Glyph(glyph);
-	}
-	else
-	    return false;
+	gm = &captured[i-first];
+	// Detect the highest and lowest point. In the case the glyph has
+	// no descender, the value must be 0!
+	descent = max(0,gm->height - gm->top);
+	ascent = max(0, max(gm->top,gm->height) - descent);
+	if ( descent > font->max_descent )
+	  font->max_descent = descent;
+	if ( ascent > font->max_ascent )
+	  font->max_ascent = ascent;
     }
 
     /* If no baseline is given, we use the maximum descend value as
@@ -750,7 +2559,11 @@ static bool check_font_metrics ( t_font_metrics *font )
     if ( flag_verbose )
     {
 	fprintf(stderr,"name:        '%s'\n",font->name);
-	fprintf(stderr,"range:       #%d..#%d\n",font_from_char,font_to_char);
+	if ( v->chars.num_ranges > 1 )
+	    fprintf(stderr,"range:       #%d..#%d, %d glyphs in %d ranges\n",v->chars.ranges[0].first,
+		    v->chars.ranges[v->chars.num_ranges-1].last,v->chars.num,v->chars.num_ranges);
+	else
+	    fprintf(stderr,"range:       #%d..#%d\n",v->chars.ranges[0].first,v->chars.ranges[0].last);
 	fprintf(stderr,"size:        %d pt\n",font->pt_size);
 	if ( font->hdpi )
 	    fprintf(stderr,"dpi:         %d x %d\n",font->hdpi,font->dpi);
@@ -764,7 +2577,7 @@ static bool check_font_metrics ( t_font_metrics *font )
 	fprintf(stderr,"nl-height:   %d\n",font->absolute_height);
 	fprintf(stderr,"max-ascent:  %d\n",font->max_ascent);
 	fprintf(stderr,"max-descent: %d\n",font->max_descent);
-	fprintf(stderr,"baseline:    calculated: %d  detected: %d (%s)\n",font->calculated_baseline,font->detected_baseline,forced_origin?"forced":"detected");
+	fprintf(stderr,"baseline:    calculated: %d  detected: %d (%s)\n",font->calculated_baseline,font->detected_baseline,v->origin?"forced":"detected");
 	fprintf(stderr,"em:          %d x %d\n",font->em.width,font->em.height);
 	fprintf(stderr,"ex:          %d x %d\n",font->ex.width,font->ex.height);
 	fprintf(stderr,"we:          %d x %d\n",font->we.width,font->we.height);
@@ -772,28 +2585,26 @@ static bool check_font_metrics ( t_font_metrics *font )
     return true;
 }
 
-/* Create the glyph matrices for all needed characters. The bitmap and the metric
- * details are written into \c font.
+/* Position the captured glyph matrices of all needed characters of the
+ * variant \c v inside the char matrix. The returned array holds one entry for
+ * glyph of \c v->chars. The bitmaps are still owned by the captured
+ * glyphs, so the caller only frees the array itself.
  */
-static t_glyph_matrix *create_glyph_matrices ( const t_font_metrics *font )
+static t_glyph_matrix *create_glyph_matrices ( t_variant *v )
 {
-    FT_Glyph glyph;
-    FT_BitmapGlyphRec *g;	// little helper
-    FT_Bitmap *bitmap;
+    const t_font_metrics *font;
     t_glyph_matrix *gmatrices;
-    bool failed = false;
-    uint8_t *p;
     int num;
     int idx;
     int tmp;
     int i;
 
-    if ( !font )
+    if ( !v || !v->captured )
     {
 	fprintf(stderr,"error: create_glyph_matrices: illegal parameters\n");
 	return NULL;
     }
-    num = font_to_char - font_from_char +1;
+    num = v->chars.num;
     if ( num <= 0 )
     {
 	fprintf(stderr,"error: create_glyph_matrices: bad number of chars\n");
@@ -807,112 +2618,74 @@ static t_glyph_matrix *create_glyph_matrices ( const t_font_metrics *font )
     }
     for ( idx=0; idx<num; idx++ )
     {
-	gmatrices[idx].sz_buffer = 0;
-	gmatrices[idx].buffer = 0;
+	if ( idx >= num-v->chars.spare )
+	{
+	    // a spare glyph is an empty one
+	    memset(&gmatrices[idx],0,sizeof(t_glyph_matrix));
+	    continue;
+	}
+	i = charset_index(&v->capture,charset_code(&v->chars,idx));
+	if ( i < 0 )
+	{
+	    fprintf(stderr,"error: create_glyph_matrices: glyph #%d not captured\n",charset_code(&v->chars,idx));
+	    free(gmatrices);
+	    return NULL;
+	}
+	gmatrices[idx] = v->captured[i];
+	gmatrices[idx].offset_y = 0;
     }
+    font = &v->font;
 
-    // the point size must be converted to '26dot6' fixed-point formast
-    FT_Set_Char_Size(face,0,(font->pt_size)<<6,font->hdpi,font->dpi);
-    for ( idx=0,i=font_from_char; i<font_to_char; i++,idx++ )
+    for ( idx=0; idx<num-1; idx++ )
     {
-	if ( create_glyph(&glyph,i) )
+	gmatrices[idx].offset_y = font->matrix.height +
+				  font->baseline -
+				  gmatrices[idx].top;		// y offset into char matrix
+
+	if ( gmatrices[idx].offset_y < 0 )
 	{
-	    if ( glyph->format != FT_GLYPH_FORMAT_BITMAP )
-	    {
-		FT_Done_Glyph(glyph);
-		fprintf(stderr,"error: check_font_metrics: glyph not in BITMAP format!\n");
-		return NULL;
-	    }
-	    bitmap = &face->glyph->bitmap;
-	    g = (FT_BitmapGlyphRec*)glyph;
-	    gmatrices[idx].width = bitmap->width;		// width of the glyph bitmap
-	    gmatrices[idx].height = bitmap->rows;		// height of the glyph bitmap
-	    gmatrices[idx].pitch = bitmap->pitch;		// no. of bytes per bitmap row
-	    gmatrices[idx].advance = face->glyph->advance.x;	// real width for proportional fonts
-
-	    gmatrices[idx].offset_x = g->left;			// x offset into char matrix
-	    gmatrices[idx].offset_y = font->matrix.height +
-				      font->baseline -
-				      g->top;			// y offset into char matrix
-
-	    if ( gmatrices[idx].offset_y < 0 )
-	    {
-		// move down
-		fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix. Move down (%d->%d).\n",idx,gmatrices[idx].offset_y,0);
-		gmatrices[idx].offset_y = 0;
-	    }
-	    else if ( (gmatrices[idx].offset_y+gmatrices[idx].height) > font->matrix.height )
-	    {
-		// move up
-		tmp = font->matrix.height - gmatrices[idx].height;
-		fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix. Move up (%d->%d).\n",idx,gmatrices[idx].offset_y,tmp);
-//~ fprintf(stderr,"    : create_glyph_matrices: glyph=%d/%d offs=%d/%d matrix=%d/%d base=%d\n",
-	//~ gmatrices[idx].width,gmatrices[idx].height,
-	//~ g->left,g->top,
-	//~ font->matrix.width,font->matrix.height,
-	//~ font->baseline);
-		gmatrices[idx].offset_y = tmp; // or tmp-1?
-	    }
-	    if ( (gmatrices[idx].offset_y<0) || ((gmatrices[idx].offset_y+gmatrices[idx].height) > font->matrix.height) )
-		fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix (Y). Will be clipped.\n",idx);
-	    if ( (gmatrices[idx].offset_x<0) || ((gmatrices[idx].offset_x+gmatrices[idx].width) > font->matrix.width) )
-		fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix (X). Will be clipped.\n",idx);
-
-	    /* Calculate the size used by the glyph bitmap and allocate the
-	     * buffer. Copy the bitmap buffer provided by the FreeType-library.
-	     * An empty bitmap leads to a size of 0 and a buffer pointer of NULL!
-	     */
-	    gmatrices[idx].sz_buffer = (bitmap->rows)*(bitmap->pitch);	// size of the buffer
-	    if ( gmatrices[idx].sz_buffer )
-	    {
-		p = malloc(gmatrices[idx].sz_buffer*sizeof(uint8_t));
-		if ( !p )
-		{
-		    // TODO: clean up prev. allocated memory here? no, we leave
-		    fprintf(stderr,"error: create_glyph_matrices: memory allocation failed\n");
-		    return NULL;
-		}
-	    }
-	    else
-		p = NULL;
-	    gmatrices[idx].buffer = p;
-	    memcpy(gmatrices[idx].buffer,bitmap->buffer,gmatrices[idx].sz_buffer);
-#ifdef DEBUG_OFF
-	    fprintf(stderr,"create_glyph_matrices: width %d needs %d bytes. size=%d\n",bitmap->width,bitmap->pitch,gmatrices[idx].sz_buffer);
-#endif
-	    FT_Done_Glyph(glyph);
+	    // move down
+	    fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix. Move down (%d->%d).\n",idx,gmatrices[idx].offset_y,0);
+	    gmatrices[idx].offset_y = 0;
 	}
-	else
+	else if ( (gmatrices[idx].offset_y+gmatrices[idx].height) > font->matrix.height )
 	{
-	    failed = true;
-	    break;
+	    // move up
+	    tmp = font->matrix.height - gmatrices[idx].height;
+	    fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix. Move up (%d->%d).\n",idx,gmatrices[idx].offset_y,tmp);
+	    gmatrices[idx].offset_y = tmp; // or tmp-1?
 	}
+	if ( (gmatrices[idx].offset_y<0) || ((gmatrices[idx].offset_y+gmatrices[idx].height) > font->matrix.height) )
+	    fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix (Y). Will be clipped.\n",idx);
+	if ( (gmatrices[idx].offset_x<0) || ((gmatrices[idx].offset_x+gmatrices[idx].width) > font->matrix.width) )
+	    fprintf(stderr,"warn: create_glyph_matrices: glyph #%d out of matrix (X). Will be clipped.\n",idx);
     }
 
-    return failed?NULL:gmatrices;
+    return gmatrices;
 }
 
 
-/* Load a glyph into the passed \c glyph variable. The caller must ensure to call
- * \c FT_Done_Glyph(glyph) after processing to free the memory.
+/* Load a glyph of the face \c fc into the passed \c glyph variable. The caller must ensure to call
+ * \c FT_Done_Glyph(glyph) after processing to free the memory. The render mode is taken from the
+ * target of \c load_flags.
  */
-static bool create_glyph ( FT_Glyph *glyph, int character )
+static bool create_glyph ( FT_Face fc, FT_Glyph *glyph, int character, int load_flags )
 {
     int err;
 
-    err = FT_Load_Char(face,character,FT_LOAD_TARGET_MONO);
+    err = FT_Load_Char(fc,character,load_flags);
     if ( err )
     {
 	fprintf(stderr,"error: create_glyph: loading char #%d (%d)\n",character,err);
 	return false;
     }
-    err = FT_Render_Glyph(face->glyph,FT_RENDER_MODE_MONO);
+    err = FT_Render_Glyph(fc->glyph,FT_LOAD_TARGET_MODE(load_flags));
     if ( err )
     {
 	fprintf(stderr,"error: create_glyph: rendering char #%d (%d)\n",character,err);
 	return false;
     }
-    err = FT_Get_Glyph(face->glyph,glyph);
+    err = FT_Get_Glyph(fc->glyph,glyph);
     if ( err )
     {
 	fprintf(stderr,"error: create_glyph: getting glyph #%d (%d)\n",character,err);
@@ -46,6 +46,33 @@
  */
 #define MAXNAME 80
 
+/* highest Unicode code point
+ */
+#define MAXCODE 0x10FFFF
+
+/* max. length of the spec of a character set (see --chars)
+ */
+#define MAXSPEC 512
+
+/* default target of the elf and asm writers (see --arch and --section)
+ */
+#define DEFAULT_ARCH "arm"
+#define DEFAULT_SECTION ".rodata.fonts"
+
+/* Format of the input hash recorded by the writers. check_file_hash()
+ * searches for this line.
+ */
+#define HASH_FORMAT "hash:         %016llx"
+
+/* Number of coverage thresholds of a 2 bit gray renderer (see --thresholds)
+ */
+#define GRAY_THRESHOLDS 3
+
+/* Compression schemes of the glyphs (see --compress)
+ */
+#define COMPRESSION_NONE 0
+#define COMPRESSION_RLE  1
+
 
 //}}}
 
@@ -67,6 +94,52 @@ typedef struct tagPIXEL_SIZE
     int height;
 } t_pixel_size;
 
+/* A range of code points. The glyphs of a character set are numbered in
+ * the order of the code points, \c index is the number of the glyph of
+ * \c first.
+ */
+typedef struct tagCHAR_RANGE
+{
+    int first;			// first code point
+    int last;			// last code point (inclusive)
+    int index;			// glyph index of \c first
+} t_char_range;
+
+/* A set of code points (see charset.c). The ranges are sorted and neither
+ * overlap nor touch each other. A simple "from..to" is a single range. The
+ * \c spare glyph indexes follow the ones of the ranges without a code point.
+ */
+typedef struct tagCHAR_SET
+{
+    t_char_range *ranges;	// allocated array of ranges
+    int num_ranges;		// number of used ranges
+    int max_ranges;		// number of allocated ranges
+    int num;			// number of glyphs (code points plus spare)
+    int spare;			// number of glyphs without a code point
+} t_char_set;
+
+/* Options of the renderers which are not part of the metrics. They are set
+ * per variant (see --thresholds, --gamma, --rotate, --pack, --compress,
+ * --dedup, --arch and --section).
+ * The gray renderers map each coverage value with \c gamma_lut before they
+ * pack it.
+ * The renderers with row major matrices rotate them clockwise by \c rotation
+ * degrees. If \c packing is set, the rows of a glyph are stored without
+ * padding and only the glyphs are aligned to \c packing bytes.
+ */
+typedef struct tagRENDER_OPTIONS
+{
+    int thresholds[GRAY_THRESHOLDS];	// min. coverage (1..255) of the gray levels 1..3
+    double gamma;			// gamma used to create gamma_lut
+    uint8_t gamma_lut[256];		// corrected value of each coverage value
+    int rotation;			// 0, 90, 180 or 270 degrees
+    int packing;			// alignment of packed glyphs (1, 2, 4) or 0
+    int compression;			// COMPRESSION_xxx used after the renderer
+    bool dedup;				// store equal glyphs only once
+    char arch[MAXNAME+1];		// machine of the object files (elf writer)
+    char section[MAXNAME+1];		// section of the font data (elf and asm writer)
+} t_render_options;
+
 /* Every thing we need to know about the font in general.
  *
  *     matrix.width
@@ -145,6 +218,8 @@ typedef struct tagGLYPH_MATRIX
     int height;			// height of the glyph bitmap
     int pitch;			// no of bytes per bitmap line
     int advance;		// real width for proportional fonts (for positioning)
+    int vert_advance;		// vertical advance (26.6 like \c advance)
+    int top;			// distance from the baseline to the top row of the bitmap
     int offset_x;		// x offset into char matrix
     int offset_y;		// y offset into char matrix
     int sz_buffer;		// size of the buffer
@@ -152,20 +227,65 @@ typedef struct tagGLYPH_MATRIX
 } t_glyph_matrix;
 
 
+/* Ink box of a glyph stored by a proportional renderer. The bitmap of the box
+ * starts at \c offset inside the buffer of the font definition and has
+ * \c height rows of \c pitch bytes. If the rows are packed, \c pitch is 0 and
+ * each row follows the previous one after \c stride bits. \c x is the left
+ * bearing (relative to the origin of the glyph), \c y the top row of the box
+ * inside the matrix and \c advance the distance to the origin of the next
+ * glyph. All values are pixels. An empty glyph has a box of 0x0 pixels.
+ */
+typedef struct tagGLYPH_BOX
+{
+    int offset;			// offset of the bitmap inside the buffer
+    int width;			// width of the box
+    int height;			// height of the box
+    int pitch;			// no of bytes per bitmap line of the box (0 if packed)
+    int stride;			// no of bits from one bitmap line to the next one
+    int x;			// left bearing
+    int y;			// top row inside the matrix
+    int advance;		// horizontal advance
+} t_glyph_box;
+
+
 /* Font definition created by the renderer and used by the writer. The renderer
  * related (created) values are preficed with "matrix_".
+ *
+ * A proportional renderer sets \c boxes. Then the glyphs are not stored in
+ * matrices of \c matrix_size bytes. The bitmaps of the boxes use the first
+ * \c buffer_size bytes of the buffer instead.
+ *
+ * After the renderer, the \c num characters are mapped to the \c num_glyphs
+ * stored glyphs by \c glyph_map (see dedup.c). The matrices and the boxes
+ * are indexed by the stored glyph. Without --dedup, this is the identity.
+ *
+ * If the glyphs are compressed, \c compressed holds the compressed bytes of
+ * each stored glyph. The glyph \c idx starts at \c compressed_offsets[idx],
+ * the offset of glyph \c num_glyphs is the end of the data.
  */
 typedef struct tagFONT_DEFINITION
 {
     char renderer[MAXNAME+1];	// guess what, the name of the renderer
     int first;			// first character code used
-    int num;			// number of character codes following
+    int num;			// number of glyphs (character codes following)
+    const t_char_set *chars;	// the code points of the glyphs
     int matrix_width;		// renderer related width of the output matrix
     int matrix_height;		// renderer related height of the output matrix
-    int matrix_pitch;		// no of bytes per bitmap line of the matrix
+    int matrix_pitch;		// no of bytes per bitmap line of the matrix (0 if packed)
+    int matrix_stride;		// no of bits from one bitmap line to the next one
     int matrix_size;		// size of the buffer for one single "final matrix"
     uint8_t *buffer;		// buffer for num*matrix_size bytes
+    t_glyph_box *boxes;		// boxes of the num glyphs (or NULL)
+    int buffer_size;		// used bytes of buffer if boxes are set
+    int num_glyphs;		// number of stored glyphs
+    int *glyph_map;		// stored glyph of each of the num characters
+    int *glyph_chars;		// first character of each stored glyph
+    uint8_t *compressed;	// compressed glyphs (or NULL)
+    int compressed_size;	// size of the compressed glyphs
+    int *compressed_offsets;	// offsets of the num_glyphs+1 compressed glyphs
     const t_font_metrics *metrics;
+    const t_render_options *options;	// set by the caller before init
+    uint64_t hash;		// hash of all inputs (font file, options, plugins)
 } t_font_definition;
 
 
@@ -178,15 +298,20 @@ typedef struct tagFONT_DEFINITION
  * The rendering process can include special requirements like "use 2 bits for
  * each pixel".
  *
+ * If \c gray is set, the glyph bitmaps are rasterized with 8 bit coverage
+ * (one byte per pixel, 0..255). Otherwise they are monochrome bitmaps with
+ * 1 bit per pixel.
+ *
  *   * init:     initialize the rendering process. Fills the passed font
  *               definition structure. Therefor it calculates the size of the
  *               resulting matrix based on the meassured bounding box. It
  *               allocates the buffer to hold all the generated bitmaps.
+ *               There is one glyph for each code point of \c chars.
  *   * generate: create the matrices for all characters.
  *   * done:     cleanup after the rendering proccess has finished.
  */
 
-typedef bool (*t_renderer_init_font_definition) ( t_font_definition *fnt, const t_font_metrics *metrics, int from, int to );
+typedef bool (*t_renderer_init_font_definition) ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
 typedef bool (*t_renderer_generate) ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
 typedef bool (*t_renderer_done) ( t_font_definition *fnt );
 
@@ -195,6 +320,7 @@ typedef struct tagRENDERER_PLUGIN
     t_renderer_init_font_definition init;	// init structure and allocate buffer
     t_renderer_generate generate;		// render all glyphs into bit matrixes
     t_renderer_done done;			// cleanup
+    bool gray;					// needs glyphs with 8 bit coverage
 } t_renderer_plugin;
 
 typedef const t_renderer_plugin* (*t_renderer_creator) ( void );
@@ -210,17 +336,24 @@ typedef const t_renderer_plugin* (*t_renderer_creator) ( void );
  *             has finished successfully.
  *   * create: create the content of the data file.
  *   * done:   cleanup after all data is written.
+ *   * uptodate: optional. Check if the files of a previous run are created
+ *             from the same inputs. The writers record \c fnt->hash in their
+ *             files for this. If true, nothing is rendered and written. The
+ *             font definition is not rendered yet, only \c metrics and \c hash
+ *             are valid. If \c filename is empty, the metrics are complete.
  */
 
 typedef bool (*t_writer_init) ( t_font_definition *fnt, const char *filename );
 typedef bool (*t_writer_create) ( t_font_definition *fnt );
 typedef bool (*t_writer_done) ( t_font_definition *fnt );
+typedef bool (*t_writer_uptodate) ( t_font_definition *fnt, const char *filename );
 
 typedef struct tagWRITER_PLUGIN
 {
     t_writer_init init;				// init file creation
     t_writer_create create;			// write all definitions
     t_writer_done done;				// cleanup
+    t_writer_uptodate uptodate;			// check previous output (or NULL)
 } t_writer_plugin;
 
 typedef const t_writer_plugin* (*t_writer_creator) ( void );
@@ -242,6 +375,9 @@ typedef const t_writer_plugin* (*t_writer_creator) ( void );
 /* exported from fontgen.c
  */
 bool is_verbose (void);
+bool check_file_hash ( const char *filename, uint64_t hash );
+FILE *open_output ( const char *filename, const char *mode );
+bool close_output ( FILE *f, const char *filename, bool keep );
 
 //}}}
 
@@ -0,0 +1,435 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: manifest.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:13:18 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Reader of the build manifest. A manifest describes all the fonts of a
+ * project. Each target section is build like a single call of fontgen with
+ * the same options. The values before the first section are the defaults
+ * for all targets. Lines starting with '#' or ';' are comments.
+ *
+ * Sample:
+ *
+ *  ,--------------------------
+ *  |# the fonts of the firmware
+ *  |font     = PT-Mono-55FT.ttf
+ *  |writer   = c-raw
+ *  |
+ *  |[PT_Mono_32]
+ *  |size     = 32
+ *  |dpi      = 72
+ *  |hdpi     = 46
+ *  |from     = 0
+ *  |to       = 255
+ *  |renderer = 2bit
+ *  `--------------------------
+ *
+ * The name of the section is used as basename of the output files. It can be
+ * changed with the key 'output'. An empty value lets the writer create the
+ * name. The output files are created in the current directory, but relative
+ * paths of 'font' and 'subset' are relative to the directory of the
+ * manifest. 'writer' may be a comma separated list (e.g. "c-raw,ascii"), all
+ * writers get the same rendered font. The other keys are 'origin', 'calc'
+ * (yes/no), 'chars' and 'subset'. The value of 'chars' is a set of code
+ * points like "U+0020-007E,U+00A0-017F". 'subset' is a comma separated list
+ * of UTF-8 text files. Only the code points used by them are rendered. Both
+ * are used instead of 'from' and 'to'. The key 'matrix' (e.g. "8x16")
+ * searches size and dpi values for a matrix of this size. 'size' is not
+ * needed then. 'thresholds' (e.g. "64,128,192") sets the coverage thresholds
+ * of the gray renderers, 'gamma' their gamma.
+ * 'rotate' (0, 90, 180 or 270) rotates the matrices clockwise. 'pack' (1, 2
+ * or 4) stores the glyphs without padding bits, aligned to this many bytes.
+ * 'compress' (rle or none) compresses each glyph. 'dedup' (yes/no) stores
+ * equal glyphs only once. 'arch' and 'section' select the machine and the
+ * section of the elf writer. 'section' is used by the asm writer too.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __MANIFEST_C__
+#include "fontgen.h"
+#include "manifest.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+/* max. length of a line of the manifest
+ */
+#define MAXLINE (MAXSPEC+32)
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static char *strip ( char *s );
+static bool parse_number ( const char *value, int *result );
+static bool set_value ( t_manifest_target *target, const char *key, const char *value, const char *dir );
+static bool resolve_paths ( char *dst, int size, const char *dir, const char *paths, bool list );
+static bool finish_target ( const char *filename, const char *section, const t_manifest_target *target, t_manifest_add add );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+/* Read the manifest \c filename and call \c add for each target. The targets
+ * are initialized with \c defaults first.
+ */
+bool read_manifest ( const char *filename, const t_manifest_target *defaults, t_manifest_add add )
+{
+    t_manifest_target common;
+    t_manifest_target target;
+    char section[MAXPATH+1] = {""};
+    char dir[MAXPATH+1];		// directory of the manifest with a trailing '/'
+    char line[MAXLINE+1];
+    char *key;
+    char *value;
+    char *p;
+    bool in_section = false;
+    int num = 0;
+    int lineno = 0;
+    FILE *f;
+
+    if ( !filename || !defaults || !add )
+    {
+	fprintf(stderr,"error: read_manifest: illegal parameters\n");
+	return false;
+    }
+    f = fopen(filename,"r");
+    if ( !f )
+    {
+	fprintf(stderr,"error: read_manifest: unable to open '%s'\n",filename);
+	return false;
+    }
+    strncpy(dir,filename,MAXPATH);
+    dir[MAXPATH]='\0';
+    p = strrchr(dir,'/');
+    *(p ? p+1 : dir) = '\0';
+    common = *defaults;
+    while ( fgets(line,sizeof(line),f) )
+    {
+	lineno++;
+	key = strip(line);
+	if ( *key=='\0' || *key=='#' || *key==';' )
+	    continue;
+	if ( *key == '[' )
+	{
+	    // a new target. The previous one is complete now.
+	    if ( in_section && !finish_target(filename,section,&target,add) )
+	    {
+		fclose(f);
+		return false;
+	    }
+	    p = strchr(key,']');
+	    if ( !p || p==key+1 )
+	    {
+		fprintf(stderr,"error: %s:%d: bad section name\n",filename,lineno);
+		fclose(f);
+		return false;
+	    }
+	    *p = '\0';
+	    strncpy(section,key+1,MAXPATH);
+	    section[MAXPATH]='\0';
+	    target = common;
+	    strncpy(target.output,section,MAXPATH);
+	    target.output[MAXPATH]='\0';
+	    in_section = true;
+	    num++;
+	    continue;
+	}
+	p = strchr(key,'=');
+	if ( !p )
+	{
+	    fprintf(stderr,"error: %s:%d: missing '='\n",filename,lineno);
+	    fclose(f);
+	    return false;
+	}
+	*p = '\0';
+	key = strip(key);
+	value = strip(p+1);
+	if ( !set_value(in_section?&target:&common,key,value,dir) )
+	{
+	    fprintf(stderr,"error: %s:%d: bad entry '%s'\n",filename,lineno,key);
+	    fclose(f);
+	    return false;
+	}
+    }
+    fclose(f);
+    if ( in_section && !finish_target(filename,section,&target,add) )
+	return false;
+    if ( num == 0 )
+    {
+	fprintf(stderr,"error: %s: no targets defined\n",filename);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"info: manifest '%s' defines %d targets\n",filename,num);
+    return true;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Remove leading and trailing white spaces (including the newline).
+ */
+static char *strip ( char *s )
+{
+    char *end;
+
+    while ( isspace((unsigned char)*s) )
+	s++;
+    end = s+strlen(s);
+    while ( end>s && isspace((unsigned char)end[-1]) )
+	*--end = '\0';
+    return s;
+}
+
+static bool parse_number ( const char *value, int *result )
+{
+    char *end;
+    long val;
+
+    val = strtol(value,&end,0);
+    if ( end==value || *end!='\0' )
+	return false;
+    *result = (int)val;
+    return true;
+}
+
+/* Prepend \c dir to each relative path of \c paths and store the result in
+ * \c dst of \c size bytes. If \c list is set, \c paths is a comma separated
+ * list. White spaces around a path are skipped. Returns false if the result
+ * is too long.
+ */
+static bool resolve_paths ( char *dst, int size, const char *dir, const char *paths, bool list )
+{
+    const char *end;
+    const char *next;
+    int len = 0;
+
+    dst[0] = '\0';
+    while ( *paths )
+    {
+	end = list ? strchr(paths,',') : NULL;
+	if ( !end )
+	    end = paths+strlen(paths);
+	next = *end ? end+1 : end;
+	while ( paths<end && isspace((unsigned char)*paths) )
+	    paths++;
+	while ( end>paths && isspace((unsigned char)end[-1]) )
+	    end--;
+	if ( end > paths )
+	{
+	    len += snprintf(dst+len,size-len,"%s%s%.*s",len?",":"",
+			    (*paths=='/')?"":dir,(int)(end-paths),paths);
+	    if ( len >= size )
+		return false;
+	}
+	paths = next;
+    }
+    return true;
+}
+
+/* Set the value of the entry \c key of \c target. The paths of the input
+ * files are relative to the directory \c dir of the manifest.
+ */
+static bool set_value ( t_manifest_target *target, const char *key, const char *value, const char *dir )
+{
+    if ( strcmp(key,"font")==0 )
+	return resolve_paths(target->font,MAXPATH+1,dir,value,false) && target->font[0]!='\0';
+    if ( strcmp(key,"output")==0 )
+    {
+	strncpy(target->output,value,MAXPATH);
+	target->output[MAXPATH]='\0';
+	return true;
+    }
+    if ( strcmp(key,"renderer")==0 )
+    {
+	strncpy(target->renderer,value,MAXNAME);
+	target->renderer[MAXNAME]='\0';
+	return target->renderer[0]!='\0';
+    }
+    if ( strcmp(key,"writer")==0 )
+    {
+	strncpy(target->writer,value,MAXNAME);
+	target->writer[MAXNAME]='\0';
+	return target->writer[0]!='\0';
+    }
+    if ( strcmp(key,"chars")==0 )
+    {
+	strncpy(target->chars,value,MAXSPEC);
+	target->chars[MAXSPEC]='\0';
+	return true;
+    }
+    if ( strcmp(key,"subset")==0 )
+	return resolve_paths(target->subset,MAXSPEC+1,dir,value,true);
+    if ( strcmp(key,"thresholds")==0 )
+    {
+	strncpy(target->thresholds,value,MAXNAME);
+	target->thresholds[MAXNAME]='\0';
+	return true;
+    }
+    if ( strcmp(key,"arch")==0 )
+    {
+	strncpy(target->arch,value,MAXNAME);
+	target->arch[MAXNAME]='\0';
+	return true;
+    }
+    if ( strcmp(key,"section")==0 )
+    {
+	strncpy(target->section,value,MAXNAME);
+	target->section[MAXNAME]='\0';
+	return true;
+    }
+    if ( strcmp(key,"gamma")==0 )
+    {
+	char *end;
+	target->gamma = strtod(value,&end);
+	return end!=value && *end=='\0' && target->gamma>0.0;
+    }
+    if ( strcmp(key,"matrix")==0 )
+    {
+	char c;
+	return sscanf(value,"%dx%d%c",&target->target.width,&target->target.height,&c)==2 &&
+	       target->target.width>0 && target->target.height>0;
+    }
+    if ( strcmp(key,"compress")==0 )
+    {
+	if ( strcmp(value,"rle")==0 )
+	    target->compression = COMPRESSION_RLE;
+	else if ( strcmp(value,"none")==0 )
+	    target->compression = COMPRESSION_NONE;
+	else
+	    return false;
+	return true;
+    }
+    if ( strcmp(key,"calc")==0 )
+    {
+	if ( strcmp(value,"yes")==0 || strcmp(value,"true")==0 || strcmp(value,"1")==0 )
+	    target->calc = true;
+	else if ( strcmp(value,"no")==0 || strcmp(value,"false")==0 || strcmp(value,"0")==0 )
+	    target->calc = false;
+	else
+	    return false;
+	return true;
+    }
+    if ( strcmp(key,"dedup")==0 )
+    {
+	if ( strcmp(value,"yes")==0 || strcmp(value,"true")==0 || strcmp(value,"1")==0 )
+	    target->dedup = true;
+	else if ( strcmp(value,"no")==0 || strcmp(value,"false")==0 || strcmp(value,"0")==0 )
+	    target->dedup = false;
+	else
+	    return false;
+	return true;
+    }
+    if ( strcmp(key,"size")==0 )
+	return parse_number(value,&target->pt_size) && target->pt_size>0;
+    if ( strcmp(key,"dpi")==0 )
+	return parse_number(value,&target->dpi) && target->dpi>0;
+    if ( strcmp(key,"hdpi")==0 )
+	return parse_number(value,&target->hdpi) && target->hdpi>=0;
+    if ( strcmp(key,"origin")==0 )
+	return parse_number(value,&target->origin);
+    if ( strcmp(key,"pack")==0 )
+	return parse_number(value,&target->packing) &&
+	       (target->packing==0 || target->packing==1 || target->packing==2 || target->packing==4);
+    if ( strcmp(key,"rotate")==0 )
+	return parse_number(value,&target->rotation) &&
+	       (target->rotation==0 || target->rotation==90 || target->rotation==180 || target->rotation==270);
+    if ( strcmp(key,"from")==0 )
+	return parse_number(value,&target->from) && target->from>=0 && target->from<=MAXCODE;
+    if ( strcmp(key,"to")==0 )
+	return parse_number(value,&target->to) && target->to>=0 && target->to<=MAXCODE;
+    return false;
+}
+
+/* Check the complete target and pass it to the caller.
+ */
+static bool finish_target ( const char *filename, const char *section, const t_manifest_target *target, t_manifest_add add )
+{
+    t_manifest_target t = *target;
+    int tmp;
+
+    if ( t.font[0] == '\0' )
+    {
+	fprintf(stderr,"error: %s: [%s]: font file not specified\n",filename,section);
+	return false;
+    }
+    if ( t.pt_size <= 0 && !t.target.width )
+    {
+	fprintf(stderr,"error: %s: [%s]: font size not specified\n",filename,section);
+	return false;
+    }
+    if ( t.to < t.from )
+    {
+	tmp = t.from;
+	t.from = t.to;
+	t.to = tmp;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"info: manifest target [%s]\n",section);
+    return add(&t);
+}
+
+//}}}
+
+/* ==[End of file]========================================================== */
@@ -0,0 +1,99 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: manifest.h
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:13:18 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ *
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#ifndef __MANIFEST_H__
+#define __MANIFEST_H__ 1
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            TYPEDECLARATIONS                             |*/
+/*`========================================================================='*/
+//{{{
+
+/* One target of a manifest. The values before the first target section are
+ * used as defaults for all targets.
+ */
+typedef struct tagMANIFEST_TARGET
+{
+    char font[MAXPATH+1];	// the font file
+    char output[MAXPATH+1];	// basename of the output. Empty means "generate one"
+    int pt_size;		// size in points
+    int dpi;			// vertical (or both) dpi
+    int hdpi;			// horizontal dpi. 0 means "same as dpi"
+    int from;			// first character code
+    int to;			// last character code
+    char chars[MAXSPEC+1];	// character set. Empty means "from..to"
+    char subset[MAXSPEC+1];	// text files to collect the characters from
+    int origin;			// forced origin. 0 means "detect"
+    bool calc;			// use calculated origin
+    t_pixel_size target;	// search size and dpi for this matrix (or 0x0)
+    char thresholds[MAXNAME+1];	// thresholds of the gray levels. Empty means "default"
+    double gamma;		// gamma of the gray renderers
+    int rotation;		// clockwise rotation of the matrices in degrees
+    int packing;		// alignment of packed glyphs in bytes. 0 means "not packed"
+    int compression;		// COMPRESSION_xxx of the glyphs
+    bool dedup;			// store equal glyphs only once
+    char arch[MAXNAME+1];	// machine of the elf writer. Empty means "default"
+    char section[MAXNAME+1];	// section of the elf writer. Empty means "default"
+    char renderer[MAXNAME+1];	// name of the renderer
+    char writer[MAXNAME+1];	// name of the writer
+} t_manifest_target;
+
+/* Called for each complete target of the manifest.
+ */
+typedef bool (*t_manifest_add) ( const t_manifest_target *target );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                     PROTOTYPES OF GLOBAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+bool read_manifest ( const char *filename, const t_manifest_target *defaults, t_manifest_add add );
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+#endif
+/* ==[End of file]========================================================== */
@@ -0,0 +1,229 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: pack.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:41:31 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Packing of the rendered glyphs (see --pack). The renderers call
+ * pack_matrices() as last step of generate(). Without packing each row of a
+ * matrix starts with a new byte, so up to 7 bits per row are unused. Packed,
+ * the rows of a glyph are stored as one continuous bitstream. Only the glyphs
+ * are aligned to 1, 2 or 4 bytes.
+ *
+ * A packed matrix has a \c matrix_pitch of 0. The rows follow each other after
+ * \c matrix_stride (= \c matrix_width) bits. The boxes of a proportional
+ * renderer are packed the same way.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __PACK_C__
+#include "fontgen.h"
+#include "pack.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool pack_rows ( t_font_definition *fnt, int align );
+static bool pack_boxes ( t_font_definition *fnt, int align );
+static int packed_size ( int width, int height, int align );
+static void put_bits ( uint8_t *dst, int pos, const uint8_t *src, int width );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+/* Pack the rows of all glyphs of \c fnt, if the render options ask for it.
+ * The buffer is replaced and the geometry of the matrices (or the boxes) is
+ * updated.
+ */
+bool pack_matrices ( t_font_definition *fnt )
+{
+    if ( !fnt || !fnt->buffer )
+    {
+	fprintf(stderr,"error: pack_matrices: illegal parameters\n");
+	return false;
+    }
+    if ( !fnt->options || !fnt->options->packing )
+	return true;
+    if ( fnt->boxes )
+	return pack_boxes(fnt,fnt->options->packing);
+    return pack_rows(fnt,fnt->options->packing);
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Pack the matrices of a renderer with a fix matrix. All matrices get the
+ * same size.
+ */
+static bool pack_rows ( t_font_definition *fnt, int align )
+{
+    const uint8_t *src;
+    uint8_t *buffer;
+    uint8_t *dst;
+    int size;
+    int idx, y;
+
+    size = packed_size(fnt->matrix_width,fnt->matrix_height,align);
+    buffer = calloc(fnt->num,size);
+    if ( !buffer )
+    {
+	fprintf(stderr,"error: pack_rows: memory allocation failed\n");
+	return false;
+    }
+    for ( idx=0; idx<fnt->num; idx++ )
+    {
+	src = fnt->buffer + (fnt->matrix_size)*idx;
+	dst = buffer + size*idx;
+	for ( y=0; y<(fnt->matrix_height); y++ )
+	    put_bits(dst,y*(fnt->matrix_width),src+(fnt->matrix_pitch)*y,fnt->matrix_width);
+    }
+
+    free(fnt->buffer);
+    fnt->buffer = buffer;
+    fnt->matrix_pitch = 0;
+    fnt->matrix_stride = fnt->matrix_width;
+    fnt->matrix_size = size;
+    return true;
+}
+
+/* Pack the boxes of a proportional renderer. Each box is stored with the
+ * size of its own bitmap. The offset of the last (unused) box is the end of
+ * the data.
+ */
+static bool pack_boxes ( t_font_definition *fnt, int align )
+{
+    t_glyph_box *box;
+    const uint8_t *src;
+    uint8_t *buffer;
+    int size;
+    int idx, y;
+
+    size = 0;
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+	size += packed_size(fnt->boxes[idx].width,fnt->boxes[idx].height,align);
+    // at least one byte, even if all glyphs are empty
+    buffer = calloc(size?size:1,sizeof(uint8_t));
+    if ( !buffer )
+    {
+	fprintf(stderr,"error: pack_boxes: memory allocation failed\n");
+	return false;
+    }
+
+    size = 0;
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	box = &fnt->boxes[idx];
+	src = fnt->buffer + box->offset;
+	for ( y=0; y<(box->height); y++ )
+	    put_bits(buffer+size,y*(box->width),src+(box->pitch)*y,box->width);
+	box->offset = size;
+	box->pitch = 0;
+	box->stride = box->width;
+	size += packed_size(box->width,box->height,align);
+    }
+    fnt->boxes[fnt->num-1].offset = size;
+
+    free(fnt->buffer);
+    fnt->buffer = buffer;
+    fnt->buffer_size = size;
+    return true;
+}
+
+/* Number of bytes used by a packed glyph of \c width x \c height bits
+ * aligned to \c align bytes.
+ */
+static int packed_size ( int width, int height, int align )
+{
+    int size = (width*height+7)/8;
+
+    return ((size+align-1)/align)*align;
+}
+
+/* Store the first \c width bits of \c src at the bit position \c pos of
+ * \c dst. The bits of \c dst must be 0.
+ */
+static void put_bits ( uint8_t *dst, int pos, const uint8_t *src, int width )
+{
+    int shift = pos&7;
+    uint8_t b;
+    int k, n;
+
+    dst += pos/8;
+    n = (width+7)/8;
+    for ( k=0; k<n; k++ )
+    {
+	b = src[k];
+	if ( k==n-1 && (width&7) )
+	    b &= 0xFF << (8-(width&7));
+	dst[k] |= b >> shift;
+	// only if the bits of b spill into the next byte
+	if ( shift && shift+width-8*k > 8 )
+	    dst[k+1] |= b << (8-shift);
+    }
+}
+
+//}}}
+
+/* ==[End of file]========================================================== */
@@ -0,0 +1,341 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: renderer-1bit-prop.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:38:40 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Proportional renderer with 1 bit for each pixel. Each glyph is cropped to
+ * its ink box. The bitmaps of the boxes are stored one after the other, each
+ * row starts with a new byte (unless packed, see --pack). The position of a
+ * box and the advance of the glyph are stored in \c fnt->boxes (see
+ * t_glyph_box). An empty glyph (like the space) has no bitmap, but an
+ * advance.
+ *
+ * \c matrix_width and \c matrix_height are the size of the line. The glyphs
+ * are not clipped to the matrix, so a box can be left of the origin or wider
+ * than the matrix.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <string.h>
+
+#define __RENDERER_1BIT_PROP_C__
+#include "fontgen.h"
+#include "renderer-1bit-prop.h"
+#include "pack.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MODULE_NAME "1bit-prop"
+
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static t_renderer_plugin this_plugin;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
+static bool done ( t_font_definition *fnt );
+static void ink_box ( const t_glyph_matrix *gm, t_glyph_box *box );
+static void copy_bits ( uint8_t *dst, const uint8_t *src, int first, int width );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+const t_renderer_plugin* renderer_1bit_prop_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] renderer_1bit_prop_creator: create renderer.\n",MODULE_NAME);
+    }
+    this_plugin.done = done;
+    this_plugin.generate = generate;
+    this_plugin.init = init_font_definition;
+    this_plugin.gray = false;
+    return &this_plugin;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Initialize the passed font definition \c fnt for the implemented renderer.
+ * The size of the bitmaps is known after the ink boxes are calculated, so
+ * only the boxes are allocated here. The buffer is allocated by generate().
+ */
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars )
+{
+    if ( !fnt || !metrics || !chars || !chars->num_ranges )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( fnt->options && fnt->options->rotation )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: rotated glyphs are not supported\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init_font_definition: called\n",MODULE_NAME);
+
+    /* Remember the font metrics and the character set. There is one glyph
+     * for each code point.
+     */
+    fnt->metrics = metrics;
+    fnt->chars = chars;
+    fnt->first = chars->ranges[0].first;
+    fnt->num = chars->num;
+    if ( fnt->num <= 0 )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: invalid number of entries (%d)\n",MODULE_NAME,fnt->num);
+	return false;
+    }
+
+    /* fill the renderer related values. The matrix is the line, the size of
+     * each glyph is stored in its box.
+     */
+    strncpy(fnt->renderer,MODULE_NAME,MAXNAME); fnt->renderer[MAXNAME]='\0';
+    fnt->matrix_width = metrics->matrix.width;
+    fnt->matrix_height = metrics->matrix.height;
+    fnt->matrix_pitch = (fnt->matrix_width+7)/8;
+    fnt->matrix_stride = 8*(fnt->matrix_pitch);
+    fnt->matrix_size = 0;
+    fnt->buffer = NULL;
+    fnt->buffer_size = 0;
+
+    fnt->boxes = calloc(fnt->num,sizeof(t_glyph_box));
+    if ( !fnt->boxes )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: memory allocation failed\n",MODULE_NAME);
+	return false;
+    }
+    return true;
+}
+
+/* Crop the glyph bitmaps to their ink boxes and store them in
+ * \c fnt->buffer. The first pass calculates the boxes and the size of the
+ * buffer, the second one copies the rows of the boxes.
+ *
+ * NOTE: an empty glyph matrix leads to a size (\c sz_buffer in \c gmatrices)
+ * of 0 and a buffer pointer (\c buffer in \c gmatrices) of NULL!
+ *
+ * @param fnt
+ * @param gmatrices the array with all glyph data and the (reduced) glyph matrix
+ */
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
+{
+    const t_glyph_matrix *gm;
+    t_glyph_box *box;
+    int idx;				// index into gmatrices[]
+    int x0, y0;				// first pixel of the box inside the glyph
+    int size;
+    int gy;
+
+    if ( !fnt || !gmatrices || !fnt->boxes )
+    {
+	fprintf(stderr,"[%s] error: generate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] generate: called\n",MODULE_NAME);
+
+    size = 0;
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	box = &fnt->boxes[idx];
+	ink_box(&gmatrices[idx],box);
+	box->offset = size;
+	box->stride = 8*(box->pitch);
+	size += (box->pitch)*(box->height);
+#ifdef DEBUG
+	fprintf(stderr,"[%s] generate: #%d box=%dx%d at %d/%d advance=%d\n",MODULE_NAME,
+		idx,box->width,box->height,box->x,box->y,box->advance);
+#endif
+    }
+    fnt->boxes[fnt->num-1].offset = size;
+
+    // at least one byte, even if all glyphs are empty
+    fnt->buffer = calloc(size?size:1,sizeof(uint8_t));
+    if ( !fnt->buffer )
+    {
+	fprintf(stderr,"[%s] error: generate: buffer allocation failed (%d)\n",MODULE_NAME,size);
+	return false;
+    }
+    fnt->buffer_size = size;
+
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	gm = &gmatrices[idx];
+	box = &fnt->boxes[idx];
+	x0 = box->x - gm->offset_x;
+	y0 = box->y - gm->offset_y;
+	for ( gy=0; gy<(box->height); gy++ )
+	    copy_bits(fnt->buffer+box->offset+(box->pitch)*gy,gm->buffer+(y0+gy)*gm->pitch,x0,box->width);
+    }
+
+    return pack_matrices(fnt);
+}
+
+/* Calculate the ink box of the glyph \c gm. The box is positioned relative to
+ * the origin (x) and the top of the matrix (y). The advance is rounded to
+ * full pixels.
+ */
+static void ink_box ( const t_glyph_matrix *gm, t_glyph_box *box )
+{
+    const uint8_t *src;
+    uint8_t b;
+    int left, right, top, bottom;	// inside the glyph bitmap
+    int gy, k, n;
+    int i;
+
+    memset(box,0,sizeof(t_glyph_box));
+    box->advance = (gm->advance+32)>>6;
+    if ( !gm->buffer )
+	return;
+
+    left = gm->width;
+    right = -1;
+    top = -1;
+    bottom = -1;
+    n = (gm->width+7)/8;
+    for ( gy=0; gy<gm->height; gy++ )
+    {
+	src = gm->buffer + gy*gm->pitch;
+	for ( k=0; k<n; k++ )
+	{
+	    b = src[k];
+	    if ( k==n-1 && (gm->width&7) )
+		b &= 0xFF << (8-(gm->width&7));
+	    if ( !b )
+		continue;
+	    if ( top < 0 )
+		top = gy;
+	    bottom = gy;
+	    for ( i=0; !(b&(0x80>>i)); i++ )
+		;
+	    if ( 8*k+i < left )
+		left = 8*k+i;
+	    for ( i=7; !(b&(0x80>>i)); i-- )
+		;
+	    if ( 8*k+i > right )
+		right = 8*k+i;
+	}
+    }
+    if ( top < 0 )
+	return;				// no ink at all
+
+    box->width = right-left+1;
+    box->height = bottom-top+1;
+    box->pitch = (box->width+7)/8;
+    box->x = gm->offset_x + left;
+    box->y = gm->offset_y + top;
+}
+
+/* Copy \c width pixels of the bitmap row \c src starting with pixel \c first
+ * to the start of the row \c dst. The unused bits of the last byte are 0.
+ */
+static void copy_bits ( uint8_t *dst, const uint8_t *src, int first, int width )
+{
+    int shift = first&7;
+    int last;				// last byte of src used
+    int n, k;
+
+    src += first/8;
+    last = (shift+width-1)/8;
+    n = (width+7)/8;
+    for ( k=0; k<n; k++ )
+    {
+	dst[k] = src[k] << shift;
+	if ( shift && k<last )
+	    dst[k] |= src[k+1] >> (8-shift);
+    }
+    if ( width&7 )
+	dst[n-1] &= 0xFF << (8-(width&7));
+}
+
+
+static bool done ( t_font_definition *fnt )
+{
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
+
+    if ( fnt->buffer )
+    {
+	free(fnt->buffer);
+	fnt->buffer = NULL;
+    }
+    if ( fnt->boxes )
+    {
+	free(fnt->boxes);
+	fnt->boxes = NULL;
+    }
+
+    return true;
+}
+
+
+
+//}}}
+
+/* ==[End of file]========================================================== */
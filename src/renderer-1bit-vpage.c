@@ -0,0 +1,319 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: renderer-1bit-vpage.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:33:15 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Renderer with 1 bit for each pixel in the layout of SSD1306 like display
+ * controllers. The matrix is split into pages of 8 pixel rows. Each page is
+ * stored as one row of the matrix with one byte for each pixel column. Bit 0
+ * of a byte is the top row of the page.
+ *
+ * So the matrix has (height+7)/8 rows of \c width bytes. \c matrix_width is
+ * the number of bits of such a row (8*width) like with the other renderers.
+ * The pages can't be rotated (see --rotate).
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <string.h>
+
+#define __RENDERER_1BIT_VPAGE_C__
+#include "fontgen.h"
+#include "renderer-1bit-vpage.h"
+#include "pack.h"
+#include "rotate.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MODULE_NAME "1bit-vpage"
+
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static t_renderer_plugin this_plugin;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
+static bool done ( t_font_definition *fnt );
+static void blit_glyph ( uint8_t *rows, int pitch, int width, int height, const t_glyph_matrix *gm );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+const t_renderer_plugin* renderer_1bit_vpage_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] renderer_1bit_vpage_creator: create renderer.\n",MODULE_NAME);
+    }
+    this_plugin.done = done;
+    this_plugin.generate = generate;
+    this_plugin.init = init_font_definition;
+    this_plugin.gray = false;
+    return &this_plugin;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Initialize the passed font definition \c fnt for the implemented renderer.
+ * The metrics of the generated glyphs is passed in \c metrics. Here we have to
+ * prepare the rendering of the glyph bitmaps into the final matrix bitmaps.
+ */
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars )
+{
+    int sz;
+
+    if ( !fnt || !metrics || !chars || !chars->num_ranges )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( fnt->options && fnt->options->rotation )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: rotated pages are not supported\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init_font_definition: called\n",MODULE_NAME);
+
+    /* Remember the font metrics and the character set. There is one glyph
+     * for each code point.
+     */
+    fnt->metrics = metrics;
+    fnt->chars = chars;
+    fnt->first = chars->ranges[0].first;
+    fnt->num = chars->num;
+    if ( fnt->num <= 0 )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: invalid number of entries (%d)\n",MODULE_NAME,fnt->num);
+	return false;
+    }
+
+    /* fill the renderer related values. Each row of the matrix is a page
+     * of 8 pixel rows with one byte for each column.
+     */
+    strncpy(fnt->renderer,MODULE_NAME,MAXNAME); fnt->renderer[MAXNAME]='\0';
+    fnt->matrix_pitch = metrics->matrix.width;
+    fnt->matrix_width = 8*(fnt->matrix_pitch);
+    fnt->matrix_stride = fnt->matrix_width;
+    fnt->matrix_height = (metrics->matrix.height+7)/8;
+    fnt->matrix_size = fnt->matrix_pitch * fnt->matrix_height;
+
+    // allocate buffer for all data bytes of the final matrices
+    sz = (fnt->matrix_size)*(fnt->num)*sizeof(uint8_t);
+    fnt->buffer = malloc(sz);
+    if ( !fnt->buffer )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: buffer allocation failed (%d)\n",MODULE_NAME,sz);
+	return false;
+    }
+    memset(fnt->buffer,0,sz);
+#ifdef DEBUG
+    fprintf(stderr,"[%s] init_font_definition: width %d needs %d pages. buffer-size=%d num=%d alloc=%d\n",MODULE_NAME,
+	    metrics->matrix.width,fnt->matrix_height,fnt->matrix_size,fnt->num,sz);
+#endif
+    return true;
+}
+
+/* Render the glyph bitmaps into the matrices of \c fnt->buffer. Each glyph
+ * is copied into a row major bitmap of whole pages first. Then each block of
+ * 8x8 pixels is transposed into 8 column bytes of a page.
+ *
+ * NOTE: an empty glyph matrix leads to a size (\c sz_buffer in \c gmatrices)
+ * of 0 and a buffer pointer (\c buffer in \c gmatrices) of NULL!
+ *
+ * @param fnt
+ * @param gmatrices the array with all glyph data and the (reduced) glyph matrix
+ */
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
+{
+    uint8_t *rows;			// row major bitmap of the glyph
+    uint8_t *matrix;			// matrix of the glyph inside fnt->buffer
+    const uint8_t *block;		// first row of a 8x8 block
+    int pitch;				// bytes per row of rows
+    int width;				// width of the matrix in pixels
+    int idx;				// index into gmatrices[]
+    int page, bx;			// page and byte column of a block
+    int x, n, i;
+    uint64_t t;
+
+    if ( !fnt || !gmatrices )
+    {
+	fprintf(stderr,"[%s] error: generate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] generate: called\n",MODULE_NAME);
+
+    // one spare byte per row takes the pixels shifted out of the last byte
+    width = fnt->metrics->matrix.width;
+    pitch = (width+7)/8 + 1;
+    rows = malloc(pitch*8*(fnt->matrix_height));
+    if ( !rows )
+    {
+	fprintf(stderr,"[%s] error: generate: memory allocation failed\n",MODULE_NAME);
+	return false;
+    }
+
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	if ( !gmatrices[idx].buffer )
+	{
+#ifdef DEBUG
+	    fprintf(stderr,"[%s] generate: #%d has no matrix\n",MODULE_NAME,idx);
+#endif
+	    continue;
+	}
+	memset(rows,0,pitch*8*(fnt->matrix_height));
+	blit_glyph(rows,pitch,width,fnt->metrics->matrix.height,&gmatrices[idx]);
+
+	matrix = fnt->buffer + (fnt->matrix_size)*idx;
+	for ( page=0; page<(fnt->matrix_height); page++ )
+	{
+	    for ( bx=0; bx*8<width; bx++ )
+	    {
+		// the bottom row of the block is the MSB of t
+		block = rows + pitch*8*page + bx;
+		t = 0;
+		for ( i=7; i>=0; i-- )
+		    t = (t<<8) | block[pitch*i];
+		if ( !t )
+		    continue;
+		t = transpose_block(t,1);
+		// the MSB of t is the left column now
+		x = 8*bx;
+		n = (width-x < 8) ? width-x : 8;
+		for ( i=0; i<n; i++ )
+		    matrix[(fnt->matrix_pitch)*page + x + i] = (uint8_t)(t >> (56-8*i));
+	    }
+	}
+    }
+
+    free(rows);
+    return pack_matrices(fnt);
+}
+
+/* Copy the glyph \c gm into the row major bitmap \c rows of \c width x
+ * \c height pixels. Pixels outside of the matrix are clipped.
+ */
+static void blit_glyph ( uint8_t *rows, int pitch, int width, int height, const t_glyph_matrix *gm )
+{
+    const uint8_t *src;
+    uint8_t *dst;
+    uint8_t b;
+    int gy, my;
+    int pos;				// pixel column of the first pixel of b
+    int k, n;
+
+    n = (gm->width+7)/8;
+    for ( gy=0; gy<gm->height; gy++ )
+    {
+	my = gm->offset_y+gy;
+	if ( my<0 || my>=height )
+	    continue;
+	src = gm->buffer + gy*gm->pitch;
+	dst = rows + pitch*my;
+	for ( k=0; k<n; k++ )
+	{
+	    b = src[k];
+	    if ( k==n-1 && (gm->width&7) )
+		b &= 0xFF << (8-(gm->width&7));
+	    pos = gm->offset_x + 8*k;
+	    if ( pos < 0 )
+	    {
+		if ( pos <= -8 )
+		    continue;
+		b <<= -pos;
+		pos = 0;
+	    }
+	    if ( !b || pos>=width )
+		continue;
+	    dst[pos/8] |= b >> (pos&7);
+	    if ( pos&7 )
+		dst[pos/8+1] |= b << (8-(pos&7));
+	}
+    }
+}
+
+static bool done ( t_font_definition *fnt )
+{
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
+
+    if ( fnt->buffer )
+    {
+	free(fnt->buffer);
+	fnt->buffer = NULL;
+    }
+
+    return true;
+}
+
+
+
+//}}}
+
+/* ==[End of file]========================================================== */
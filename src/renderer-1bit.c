@@ -20,6 +20,8 @@
 #define __RENDERER_1BIT_C__
 #include "fontgen.h"
 #include "renderer-1bit.h"
+#include "rotate.h"
+#include "pack.h"
 
 
 /*+=========================================================================+*/
@@ -64,8 +66,10 @@ static t_renderer_plugin this_plugin;
 /*`========================================================================='*/
 //{{{
 
-static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, int from, int to );
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
 static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
+static void blit_row ( uint8_t *dst, int shift, const uint8_t *src, int width );
+static bool blit_pixels ( t_font_definition *fnt, const t_glyph_matrix *gm, uint8_t *matrix, int idx );
 static bool done ( t_font_definition *fnt );
 
 //}}}
@@ -84,6 +88,7 @@ const t_renderer_plugin* renderer_1bit_creator ( void )
     this_plugin.done = done;
     this_plugin.generate = generate;
     this_plugin.init = init_font_definition;
+    this_plugin.gray = false;
     return &this_plugin;
 }
 
@@ -104,11 +109,11 @@ const t_renderer_plugin* renderer_1bit_creator ( void )
  * The metrics of the generated glyphs is passed in \c metrics. Here we have to
  * prepare the rendering of the glyph bitmaps into the final matrix bitmaps.
  */
-static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, int from, int to )
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars )
 {
     int sz;
 
-    if ( !fnt || !metrics || from<0 || to<0 )
+    if ( !fnt || !metrics || !chars || !chars->num_ranges )
     {
 	fprintf(stderr,"[%s] error: init_font_definition: illegal parameters\n",MODULE_NAME);
 	return false;
@@ -116,12 +121,13 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
     if ( is_verbose() )
 	fprintf(stderr,"[%s] init_font_definition: called\n",MODULE_NAME);
 
-    /* Remember the font metrics and save the range as start character and
-     * number of characters.
+    /* Remember the font metrics and the character set. There is one glyph
+     * for each code point.
      */
     fnt->metrics = metrics;
-    fnt->first = from;
-    fnt->num = to-from+1;
+    fnt->chars = chars;
+    fnt->first = chars->ranges[0].first;
+    fnt->num = chars->num;
     if ( fnt->num <= 0 )
     {
 	fprintf(stderr,"[%s] error: init_font_definition: invalid number of entries (%d)\n",MODULE_NAME,fnt->num);
@@ -139,6 +145,7 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
     fnt->matrix_pitch = fnt->matrix_width/8;
     if ( fnt->matrix_width%8 )
 	fnt->matrix_pitch++;
+    fnt->matrix_stride = 8*(fnt->matrix_pitch);
     fnt->matrix_size = fnt->matrix_pitch * fnt->matrix_height;
 
     // allocate buffer for all data bytes of the final matrices
@@ -157,7 +164,81 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
     return true;
 }
 
-/*
+/* OR \c width pixels of the glyph row \c src into the matrix row \c dst.
+ * The first pixel is written to the bit \c shift (0..7, MSB first) of
+ * \c dst[0]. The row is copied in chunks of up to 56 pixels, which are
+ * shifted as a whole. Pixels behind \c width are masked out, bytes behind
+ * the last pixel are not touched.
+ */
+static void blit_row ( uint8_t *dst, int shift, const uint8_t *src, int width )
+{
+    uint64_t acc;			// chunk of pixels, first one is bit 63
+    int bits;				// pixels in this chunk
+    int n, i;
+
+    while ( width > 0 )
+    {
+	bits = (width>56) ? 56 : width;
+	n = (bits+7)/8;
+	acc = 0;
+	for ( i=0; i<n; i++ )
+	    acc |= (uint64_t)src[i] << (56-8*i);
+	acc &= ~(uint64_t)0 << (64-bits);
+	acc >>= shift;
+	n = (shift+bits+7)/8;
+	for ( i=0; i<n; i++ )
+	    dst[i] |= (uint8_t)(acc >> (56-8*i));
+	src += 7;
+	dst += 7;
+	width -= bits;
+    }
+}
+
+/* Copy the glyph \c gm pixel by pixel into the matrix \c matrix. This is
+ * used for glyphs not completely inside the matrix buffer. A pixel behind
+ * the end of a row is set in the next row.
+ */
+static bool blit_pixels ( t_font_definition *fnt, const t_glyph_matrix *gm, uint8_t *matrix, int idx )
+{
+    int offs;				// offset into matrix
+    uint8_t bit;			// bitmask
+    int byte;				// byte within row
+    int gx, gy;				// pixel coordinates inside the glyph
+    int mx, my;				// pixel coordinates inside the output matrix
+
+    for ( gy=0; gy<gm->height; gy++ )
+    {
+	for ( gx=0; gx<gm->width; gx++ )
+	{
+	    byte = gx / 8;
+	    bit = 0x80 >> (gx&7);
+	    if ( (gm->buffer[gy*gm->pitch+byte]&bit) )
+	    {
+		// set the pixel[mx|my] inside the matrix
+		mx = gm->offset_x+gx;
+		my = gm->offset_y+gy;
+		offs = (fnt->matrix_pitch)*my + mx/8;
+		if ( offs >= fnt->matrix_size )
+		{
+#ifdef DEBUG
+		    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d] (absolute %d|%d)! (%d > %d)\n",
+			    MODULE_NAME,idx,gx,gy,mx,my,offs,fnt->matrix_size);
+#else
+		    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d]!\n",
+			    MODULE_NAME,idx,gx,gy);
+#endif
+		    return false;
+		}
+		matrix[offs] |= 0x80 >> (mx&7);
+	    }
+	}
+    }
+    return true;
+}
+
+/* Render the glyph bitmaps into the matrices of \c fnt->buffer. The bounds
+ * are checked once per glyph. If the glyph fits into the matrix buffer, the
+ * rows are copied with blit_row(). Otherwise blit_pixels() is used.
  *
  * NOTE: an empty glyph matrix leads to a size (\c sz_buffer in \c gmatrices)
  * of 0 and a buffer pointer (\c buffer in \c gmatrices) of NULL!
@@ -167,14 +248,12 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
  */
 static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
 {
-    int offs;				// offset into fnt->buffer
+    const t_glyph_matrix *gm;
+    uint8_t *matrix;			// matrix of the glyph inside fnt->buffer
     int idx;				// index into gmatrices[]
-    uint8_t bit;			// bitmask
-    int byte;				// byte within row
-    uint8_t mbit;			// bitmask for matrix
-    int mbyte;				// byte within matrix row
-    int gx, gy;				// pixel coordinates inside the glyph
-    int mx, my;				// pixel coordinates inside the output matrix
+    int gy;				// row inside the glyph
+    int mx, my;				// position of the glyph inside the output matrix
+    int pos;				// bit offset of a glyph row inside the matrix
 
     if ( !fnt || !gmatrices )
     {
@@ -186,79 +265,37 @@ static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
 
     for ( idx=0; idx<(fnt->num-1); idx++ )
     {
-	if ( gmatrices[idx].buffer )
+	gm = &gmatrices[idx];
+	if ( !gm->buffer || gm->width<=0 || gm->height<=0 )
 	{
-	    // render gmatrices[idx] into fnt->buffer[offs]
-	    mx = gmatrices[idx].offset_x;
-	    my = gmatrices[idx].offset_y;
 #ifdef DEBUG
-	    fprintf(stderr,"[%s] generate: #%d offs=%d/%d glyph=%d/%d base=%d\n",MODULE_NAME,
-	                   idx,mx,my,
-			   gmatrices[idx].width,gmatrices[idx].height,
-			   fnt->metrics->baseline);
-#endif
-	    for ( gy=0; gy<gmatrices[idx].height; gy++ )
-	    {
-		for ( gx=0; gx<gmatrices[idx].width; gx++ )
-		{
-		    byte = gx / 8;
-		    bit = 0x80 >> (gx&7);
-#ifdef DEBUG_OFF
-		    if ( (gmatrices[idx].buffer[gy*gmatrices[idx].pitch+byte]&bit) )
-			printf("*");
-		    else
-			printf(".");
-#endif
-		    if ( (gmatrices[idx].buffer[gy*gmatrices[idx].pitch+byte]&bit) )
-		    {
-			// set the pixel[mx+gx|my+gy] inside the matrix
-			mbyte = (mx+gx) / 8;
-			mbit = 0x80 >> ((mx+gx)&7);
-			offs = ((fnt->matrix_pitch)*(my+gy)+mbyte);
-			if ( offs >= fnt->matrix_size )
-			{
-#ifdef DEBUG
-			    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d] (absolute %d|%d)! (%d > %d)\n",
-			            MODULE_NAME,idx,gx,gy,(mx+gx),(my+gy),offs,fnt->matrix_size);
-#else
-			    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d]!\n",
-			            MODULE_NAME,idx,gx,gy);
-#endif
-			    return false;
-			}
-			offs += (fnt->matrix_size) * idx;
-			fnt->buffer[offs] |= mbit;
-		    }
-		}
-#ifdef DEBUG_OFF
-		printf("\n");
-#endif
-	    }
-#ifdef DEBUG_OFF
-	    for ( my=0; my<(fnt->metrics->matrix.height); my++ )
-	    {
-		for ( mx=0; mx<(fnt->metrics->matrix.width); mx++ )
-		{
-		    offs = (fnt->matrix_size) * idx;
-		    mbyte = mx / 8;
-		    mbit = 0x80 >> (mx&7);
-		    offs += (mpitch*(my)+mbyte);
-		    if ( fnt->buffer[offs]&mbit )
-			printf("*");
-		    else
-			printf(".");
-		}
-		printf("\n");
-	    }
+	    fprintf(stderr,"[%s] generate: #%d has no matrix\n",MODULE_NAME,idx);
 #endif
+	    continue;
 	}
+	// render gmatrices[idx] into the matrix of idx
+	mx = gm->offset_x;
+	my = gm->offset_y;
+	matrix = fnt->buffer + (fnt->matrix_size)*idx;
 #ifdef DEBUG
-	else
-	    fprintf(stderr,"[%s] generate: #%d has no matrix\n",MODULE_NAME,idx);
+	fprintf(stderr,"[%s] generate: #%d offs=%d/%d glyph=%d/%d base=%d\n",MODULE_NAME,
+		idx,mx,my,gm->width,gm->height,fnt->metrics->baseline);
 #endif
+	if ( mx<0 || my<0 ||
+	     (fnt->matrix_pitch)*(my+gm->height-1) + (mx+gm->width-1)/8 >= fnt->matrix_size )
+	{
+	    if ( !blit_pixels(fnt,gm,matrix,idx) )
+		return false;
+	    continue;
+	}
+	for ( gy=0; gy<gm->height; gy++ )
+	{
+	    pos = (fnt->matrix_pitch)*8*(my+gy) + mx;
+	    blit_row(matrix+pos/8,pos&7,gm->buffer+gy*gm->pitch,gm->width);
+	}
     }
 
-    return true;
+    return rotate_matrices(fnt,1) && pack_matrices(fnt);
 }
 
 
@@ -0,0 +1,278 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: renderer-2bit-gray.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:30:30 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Antialiased renderer with 2 bits for each pixel. The glyphs are rasterized
+ * with 8 bit coverage, corrected by the gamma table and quantized to the
+ * gray levels 0..3 by the thresholds of the render options (see
+ * --thresholds). The layout of the matrix is the same as the one of the
+ * "2bit" renderer. Level 3 is full coverage.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <string.h>
+
+#define __RENDERER_2BIT_GRAY_C__
+#include "fontgen.h"
+#include "renderer-2bit-gray.h"
+#include "rotate.h"
+#include "pack.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MODULE_NAME "2bit-gray"
+
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static t_renderer_plugin this_plugin;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
+static bool done ( t_font_definition *fnt );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+const t_renderer_plugin* renderer_2bit_gray_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] renderer_2bit_gray_creator: create renderer.\n",MODULE_NAME);
+    }
+    this_plugin.done = done;
+    this_plugin.generate = generate;
+    this_plugin.init = init_font_definition;
+    this_plugin.gray = true;
+    return &this_plugin;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Initialize the passed font definition \c fnt for the implemented renderer.
+ * The metrics of the generated glyphs is passed in \c metrics. Here we have to
+ * prepare the rendering of the glyph bitmaps into the final matrix bitmaps.
+ */
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars )
+{
+    int sz;
+
+    if ( !fnt || !metrics || !chars || !chars->num_ranges || !fnt->options )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init_font_definition: called\n",MODULE_NAME);
+
+    /* Remember the font metrics and the character set. There is one glyph
+     * for each code point.
+     */
+    fnt->metrics = metrics;
+    fnt->chars = chars;
+    fnt->first = chars->ranges[0].first;
+    fnt->num = chars->num;
+    if ( fnt->num <= 0 )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: invalid number of entries (%d)\n",MODULE_NAME,fnt->num);
+	return false;
+    }
+
+    /* fill the renderer related values
+     */
+    strncpy(fnt->renderer,MODULE_NAME,MAXNAME); fnt->renderer[MAXNAME]='\0';
+    fnt->matrix_width = 2*(metrics->matrix.width);
+    fnt->matrix_height = metrics->matrix.height;
+
+    /* calculate the number of bytes used to store a row inside the buffer.
+     */
+    fnt->matrix_pitch = fnt->matrix_width/8;
+    if ( fnt->matrix_width%8 )
+	fnt->matrix_pitch++;
+    fnt->matrix_stride = 8*(fnt->matrix_pitch);
+    fnt->matrix_size = fnt->matrix_pitch * fnt->matrix_height;
+
+    // allocate buffer for all data bytes of the final matrices
+    sz = (fnt->matrix_size)*(fnt->num)*sizeof(uint8_t);
+    fnt->buffer = malloc(sz);
+    if ( !fnt->buffer )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: buffer allocation failed (%d)\n",MODULE_NAME,sz);
+	return false;
+    }
+    memset(fnt->buffer,0,sz);
+#ifdef DEBUG
+    fprintf(stderr,"[%s] init_font_definition: width %d needs %d bytes. buffer-size=%d num=%d alloc=%d\n",MODULE_NAME,
+	    metrics->matrix.width,fnt->matrix_pitch,fnt->matrix_size,fnt->num,sz);
+#endif
+    return true;
+}
+
+/* Quantize the coverage of the glyph bitmaps and store the gray levels in
+ * the matrices of \c fnt->buffer. The glyph bitmaps have one byte for each
+ * pixel. The gray level of each coverage value is taken from a table build
+ * from the gamma table and the thresholds of \c fnt->options. The visible
+ * part of a glyph is calculated once, pixels outside of the matrix are
+ * clipped.
+ *
+ * NOTE: an empty glyph matrix leads to a size (\c sz_buffer in \c gmatrices)
+ * of 0 and a buffer pointer (\c buffer in \c gmatrices) of NULL!
+ *
+ * @param fnt
+ * @param gmatrices the array with all glyph data and the (reduced) glyph matrix
+ */
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
+{
+    uint8_t levels[256];		// gray level of each coverage value
+    const t_glyph_matrix *gm;
+    const uint8_t *src;			// row of the glyph bitmap
+    uint8_t *dst;			// row of the matrix
+    int idx;				// index into gmatrices[]
+    int gx, gy;				// pixel coordinates inside the glyph
+    int x0, x1, y0, y1;			// visible part of the glyph
+    int mx;				// pixel column inside the output matrix
+    int level;
+    int c;
+
+    if ( !fnt || !gmatrices )
+    {
+	fprintf(stderr,"[%s] error: generate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] generate: called\n",MODULE_NAME);
+
+    for ( c=0; c<256; c++ )
+    {
+	level = 0;
+	while ( level<GRAY_THRESHOLDS && fnt->options->gamma_lut[c]>=fnt->options->thresholds[level] )
+	    level++;
+	levels[c] = level;
+    }
+
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	gm = &gmatrices[idx];
+	if ( !gm->buffer )
+	{
+#ifdef DEBUG
+	    fprintf(stderr,"[%s] generate: #%d has no matrix\n",MODULE_NAME,idx);
+#endif
+	    continue;
+	}
+#ifdef DEBUG
+	fprintf(stderr,"[%s] generate: #%d offs=%d/%d glyph=%d/%d base=%d\n",MODULE_NAME,
+		idx,gm->offset_x,gm->offset_y,gm->width,gm->height,fnt->metrics->baseline);
+#endif
+	x0 = (gm->offset_x<0) ? -gm->offset_x : 0;
+	x1 = fnt->metrics->matrix.width - gm->offset_x;
+	if ( x1 > gm->width )
+	    x1 = gm->width;
+	y0 = (gm->offset_y<0) ? -gm->offset_y : 0;
+	y1 = fnt->matrix_height - gm->offset_y;
+	if ( y1 > gm->height )
+	    y1 = gm->height;
+	for ( gy=y0; gy<y1; gy++ )
+	{
+	    src = gm->buffer + gy*gm->pitch;
+	    dst = fnt->buffer + (fnt->matrix_size)*idx + (fnt->matrix_pitch)*(gm->offset_y+gy);
+	    for ( gx=x0; gx<x1; gx++ )
+	    {
+		level = levels[src[gx]];
+		if ( level )
+		{
+		    mx = gm->offset_x+gx;
+		    dst[mx/4] |= level << (6-2*(mx&3));
+		}
+	    }
+	}
+    }
+
+    return rotate_matrices(fnt,2) && pack_matrices(fnt);
+}
+
+
+static bool done ( t_font_definition *fnt )
+{
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
+
+    if ( fnt->buffer )
+    {
+	free(fnt->buffer);
+	fnt->buffer = NULL;
+    }
+
+    return true;
+}
+
+
+
+//}}}
+
+/* ==[End of file]========================================================== */
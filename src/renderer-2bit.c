@@ -9,15 +9,29 @@
  * --------------------------------------------------------------------------
  * DESCRIPTION:
  *
+ * Each pixel of a glyph becomes a pair of bits. A glyph row is spread with
+ * a table of 256 pixel pairs. On x86, SSE2 or AVX2 kernels spread 8 or 16
+ * bytes of a row at once. The kernel is selected by the CPU at runtime.
+ *
  * --------------------------------------------------------------------------
  * COMPILER-FLAGS:
  *
+ * The SIMD kernels need a GCC compatible compiler (target attribute and
+ * __builtin_cpu_supports). Other compilers use the table only.
+ *
  * --------------------------------------------------------------------------
  */
 
 #define __RENDERER_2BIT_C__
 #include "fontgen.h"
 #include "renderer-2bit.h"
+#include "rotate.h"
+#include "pack.h"
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define HAVE_SIMD_KERNELS 1
+#include <immintrin.h>
+#endif
 
 
 /*+=========================================================================+*/
@@ -40,6 +54,12 @@
 /*|                          LOCAL TYPEDECLARATIONS                         |*/
 /*`========================================================================='*/
 //{{{
+
+/* A kernel spreads the shifted source bytes \c j.. of a row as long as a
+ * full block fits below \c full. It returns the next byte to be spread.
+ */
+typedef int (*t_spread_kernel) ( uint8_t *dst, const uint8_t *src, int k, int j, int full );
+
 //}}}
 
 /*+=========================================================================+*/
@@ -54,6 +74,8 @@
 //{{{
 
 static t_renderer_plugin this_plugin;
+static uint16_t spread_table[256];		// the pixel pairs of each byte
+static t_spread_kernel spread_kernel = NULL;	// NULL if there is no SIMD
 
 //}}}
 
@@ -62,8 +84,15 @@ static t_renderer_plugin this_plugin;
 /*`========================================================================='*/
 //{{{
 
-static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, int from, int to );
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
 static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
+static void init_spread_table ( void );
+#ifdef HAVE_SIMD_KERNELS
+static int spread_sse2 ( uint8_t *dst, const uint8_t *src, int k, int j, int full );
+static int spread_avx2 ( uint8_t *dst, const uint8_t *src, int k, int j, int full );
+#endif
+static void blit_row ( uint8_t *dst, int shift, const uint8_t *src, int width );
+static bool blit_pixels ( t_font_definition *fnt, const t_glyph_matrix *gm, uint8_t *matrix, int idx );
 static bool done ( t_font_definition *fnt );
 
 //}}}
@@ -82,6 +111,18 @@ const t_renderer_plugin* renderer_2bit_creator ( void )
     this_plugin.done = done;
     this_plugin.generate = generate;
     this_plugin.init = init_font_definition;
+    this_plugin.gray = false;
+    init_spread_table();
+#ifdef HAVE_SIMD_KERNELS
+    __builtin_cpu_init();
+    if ( __builtin_cpu_supports("avx2") )
+	spread_kernel = spread_avx2;
+    else if ( __builtin_cpu_supports("sse2") )
+	spread_kernel = spread_sse2;
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] renderer_2bit_creator: %s kernel\n",MODULE_NAME,
+		(spread_kernel==spread_avx2)?"AVX2":(spread_kernel==spread_sse2)?"SSE2":"table");
+#endif
     return &this_plugin;
 }
 
@@ -102,11 +143,11 @@ const t_renderer_plugin* renderer_2bit_creator ( void )
  * The metrics of the generated glyphs is passed in \c metrics. Here we have to
  * prepare the rendering of the glyph bitmaps into the final matrix bitmaps.
  */
-static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, int from, int to )
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars )
 {
     int sz;
 
-    if ( !fnt || !metrics || from<0 || to<0 )
+    if ( !fnt || !metrics || !chars || !chars->num_ranges )
     {
 	fprintf(stderr,"[%s] error: init_font_definition: illegal parameters\n",MODULE_NAME);
 	return false;
@@ -114,12 +155,13 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
     if ( is_verbose() )
 	fprintf(stderr,"[%s] init_font_definition: called\n",MODULE_NAME);
 
-    /* Remember the font metrics and save the range as start character and
-     * number of characters.
+    /* Remember the font metrics and the character set. There is one glyph
+     * for each code point.
      */
     fnt->metrics = metrics;
-    fnt->first = from;
-    fnt->num = to-from+1;
+    fnt->chars = chars;
+    fnt->first = chars->ranges[0].first;
+    fnt->num = chars->num;
     if ( fnt->num <= 0 )
     {
 	fprintf(stderr,"[%s] error: init_font_definition: invalid number of entries (%d)\n",MODULE_NAME,fnt->num);
@@ -137,6 +179,7 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
     fnt->matrix_pitch = fnt->matrix_width/8;
     if ( fnt->matrix_width%8 )
 	fnt->matrix_pitch++;
+    fnt->matrix_stride = 8*(fnt->matrix_pitch);
     fnt->matrix_size = fnt->matrix_pitch * fnt->matrix_height;
 
     // allocate buffer for all data bytes of the final matrices
@@ -155,7 +198,183 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
     return true;
 }
 
-/*
+/* Fill spread_table. The first pixel of a byte (MSB) becomes bit 15 of its
+ * entry, so the high byte of the entry is the first matrix byte.
+ */
+static void init_spread_table ( void )
+{
+    int value, i;
+
+    for ( value=0; value<256; value++ )
+    {
+	spread_table[value] = 0;
+	for ( i=0; i<8; i++ )
+	{
+	    if ( value&(0x80>>i) )
+		spread_table[value] |= 0x8000 >> (2*i);
+	}
+    }
+}
+
+#ifdef HAVE_SIMD_KERNELS
+/* Spread the source bytes from \c j on in blocks of 8. The source byte j is
+ * (src[j]>>k)|(src[j-1]<<(8-k)), so \c j must be at least 1. Each byte is
+ * held in a 16 bit lane. Its high nibble is moved to the low byte of the
+ * lane and the low nibble to the high byte, which is the order of the bytes
+ * in memory. Then the nibbles are interleaved with zeros.
+ */
+__attribute__((target("sse2")))
+static int spread_sse2 ( uint8_t *dst, const uint8_t *src, int k, int j, int full )
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rk = _mm_cvtsi32_si128(k);
+    const __m128i lk = _mm_cvtsi32_si128(8-k);
+    __m128i cur, prev, v, d;
+
+    for ( ; j+8<=full; j+=8 )
+    {
+	cur = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src+j)),zero);
+	prev = _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(src+j-1)),zero);
+	v = _mm_and_si128(_mm_or_si128(_mm_srl_epi16(cur,rk),_mm_sll_epi16(prev,lk)),_mm_set1_epi16(0x00FF));
+	v = _mm_or_si128(_mm_and_si128(_mm_srli_epi16(v,4),_mm_set1_epi16(0x000F)),
+			 _mm_and_si128(_mm_slli_epi16(v,8),_mm_set1_epi16(0x0F00)));
+	v = _mm_and_si128(_mm_or_si128(v,_mm_slli_epi16(v,2)),_mm_set1_epi16(0x3333));
+	v = _mm_and_si128(_mm_or_si128(v,_mm_slli_epi16(v,1)),_mm_set1_epi16(0x5555));
+	v = _mm_add_epi16(v,v);
+	d = _mm_loadu_si128((const __m128i*)(dst+2*j));
+	_mm_storeu_si128((__m128i*)(dst+2*j),_mm_or_si128(d,v));
+    }
+    return j;
+}
+
+/* Like spread_sse2(), but in blocks of 16 bytes. The rest of the row is
+ * passed to spread_sse2().
+ */
+__attribute__((target("avx2")))
+static int spread_avx2 ( uint8_t *dst, const uint8_t *src, int k, int j, int full )
+{
+    const __m128i rk = _mm_cvtsi32_si128(k);
+    const __m128i lk = _mm_cvtsi32_si128(8-k);
+    __m256i cur, prev, v, d;
+
+    for ( ; j+16<=full; j+=16 )
+    {
+	cur = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src+j)));
+	prev = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(src+j-1)));
+	v = _mm256_and_si256(_mm256_or_si256(_mm256_srl_epi16(cur,rk),_mm256_sll_epi16(prev,lk)),
+			     _mm256_set1_epi16(0x00FF));
+	v = _mm256_or_si256(_mm256_and_si256(_mm256_srli_epi16(v,4),_mm256_set1_epi16(0x000F)),
+			    _mm256_and_si256(_mm256_slli_epi16(v,8),_mm256_set1_epi16(0x0F00)));
+	v = _mm256_and_si256(_mm256_or_si256(v,_mm256_slli_epi16(v,2)),_mm256_set1_epi16(0x3333));
+	v = _mm256_and_si256(_mm256_or_si256(v,_mm256_slli_epi16(v,1)),_mm256_set1_epi16(0x5555));
+	v = _mm256_add_epi16(v,v);
+	d = _mm256_loadu_si256((const __m256i*)(dst+2*j));
+	_mm256_storeu_si256((__m256i*)(dst+2*j),_mm256_or_si256(d,v));
+    }
+    // leave the AVX state before the SSE2 code runs
+    _mm256_zeroupper();
+    return spread_sse2(dst,src,k,j,full);
+}
+#endif
+
+/* OR \c width pixels of the glyph row \c src as pixel pairs into the matrix
+ * row \c dst. The first pair starts at bit \c shift (0,2,4,6, MSB first) of
+ * \c dst[0]. Only the high bit of a pair is set. The source is shifted by
+ * \c shift/2 pixels, so each source byte j gives the matrix bytes 2j and
+ * 2j+1. The full bytes are spread by the SIMD kernel or the table. Pixels
+ * behind \c width are masked out, bytes behind the last pair are not
+ * touched.
+ */
+static void blit_row ( uint8_t *dst, int shift, const uint8_t *src, int width )
+{
+    int k;				// pixels the source is shifted by
+    int full;				// number of source bytes with 8 pixels
+    int rest;				// pixels of the last source byte
+    uint16_t w;				// spread source byte
+    uint8_t b;				// shifted source byte
+    int j;
+
+    k = shift/2;
+    full = (k+width)/8;
+    rest = (k+width)&7;
+    j = 0;
+    if ( full )
+    {
+	b = src[0] >> k;
+	w = spread_table[b];
+	dst[0] |= (uint8_t)(w>>8);
+	dst[1] |= (uint8_t)w;
+	j = 1;
+    }
+    if ( spread_kernel && full>8 )
+	j = spread_kernel(dst,src,k,j,full);
+    for ( ; j<full; j++ )
+    {
+	b = (uint8_t)((src[j]>>k) | (src[j-1]<<(8-k)));
+	w = spread_table[b];
+	dst[2*j] |= (uint8_t)(w>>8);
+	dst[2*j+1] |= (uint8_t)w;
+    }
+    if ( rest )
+    {
+	b = (j<(width+7)/8) ? (src[j]>>k) : 0;
+	if ( j )
+	    b |= (uint8_t)(src[j-1]<<(8-k));
+	b &= (uint8_t)(0xFF<<(8-rest));
+	w = spread_table[b];
+	dst[2*j] |= (uint8_t)(w>>8);
+	if ( rest > 4 )
+	    dst[2*j+1] |= (uint8_t)w;
+    }
+}
+
+/* Copy the glyph \c gm pixel by pixel into the matrix \c matrix. This is
+ * used for glyphs not completely inside the matrix buffer. A pixel behind
+ * the end of a row is set in the next row.
+ */
+static bool blit_pixels ( t_font_definition *fnt, const t_glyph_matrix *gm, uint8_t *matrix, int idx )
+{
+    int offs;				// offset into matrix
+    uint8_t bit;			// bitmask
+    int byte;				// byte within row
+    int gx, gy;				// pixel coordinates inside the glyph
+    int mx, my;				// pixel coordinates inside the output matrix
+
+    for ( gy=0; gy<gm->height; gy++ )
+    {
+	for ( gx=0; gx<gm->width; gx++ )
+	{
+	    byte = gx / 8;
+	    bit = 0x80 >> (gx&7);
+	    if ( (gm->buffer[gy*gm->pitch+byte]&bit) )
+	    {
+		// set the pixel[mx|my] inside the matrix and leave
+		// pixel[mx+1|my] untouched.
+		mx = gm->offset_x+gx;
+		my = gm->offset_y+gy;
+		offs = (fnt->matrix_pitch)*my + (mx*2)/8;
+		if ( offs >= fnt->matrix_size )
+		{
+#ifdef DEBUG
+		    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d] (absolute %d|%d)! (%d > %d)\n",
+			    MODULE_NAME,idx,gx,gy,mx*2,my,offs,fnt->matrix_size);
+#else
+		    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d]!\n",
+			    MODULE_NAME,idx,gx,gy);
+#endif
+		    return false;
+		}
+		matrix[offs] |= 0x80 >> ((mx*2)&7);
+	    }
+	}
+    }
+    return true;
+}
+
+/* Render the glyph bitmaps into the matrices of \c fnt->buffer. Each pixel
+ * of a glyph becomes a pair of bits. The bounds are checked once per glyph.
+ * If the glyph fits into the matrix buffer, the rows are expanded with
+ * blit_row(). Otherwise blit_pixels() is used.
  *
  * NOTE: an empty glyph matrix leads to a size (\c sz_buffer in \c gmatrices)
  * of 0 and a buffer pointer (\c buffer in \c gmatrices) of NULL!
@@ -165,14 +384,12 @@ static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics
  */
 static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
 {
-    int offs;				// offset into fnt->buffer
+    const t_glyph_matrix *gm;
+    uint8_t *matrix;			// matrix of the glyph inside fnt->buffer
     int idx;				// index into gmatrices[]
-    uint8_t bit;			// bitmask
-    int byte;				// byte within row
-    uint8_t mbit;			// bitmask for matrix
-    int mbyte;				// byte within matrix row
-    int gx, gy;				// pixel coordinates inside the glyph
-    int mx, my;				// pixel coordinates inside the output matrix
+    int gy;				// row inside the glyph
+    int mx, my;				// position of the glyph inside the output matrix
+    int pos;				// bit offset of a glyph row inside the matrix
 
     if ( !fnt || !gmatrices )
     {
@@ -184,80 +401,37 @@ static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
 
     for ( idx=0; idx<(fnt->num-1); idx++ )
     {
-	if ( gmatrices[idx].buffer )
+	gm = &gmatrices[idx];
+	if ( !gm->buffer || gm->width<=0 || gm->height<=0 )
 	{
-	    // render gmatrices[idx] into fnt->buffer[offs]
-	    mx = gmatrices[idx].offset_x;
-	    my = gmatrices[idx].offset_y;
-#ifdef DEBUG
-	    fprintf(stderr,"[%s] generate: #%d offs=%d/%d glyph=%d/%d base=%d\n",MODULE_NAME,
-	                   idx,mx,my,
-			   gmatrices[idx].width,gmatrices[idx].height,
-			   fnt->metrics->baseline);
-#endif
-	    for ( gy=0; gy<gmatrices[idx].height; gy++ )
-	    {
-		for ( gx=0; gx<gmatrices[idx].width; gx++ )
-		{
-		    byte = gx / 8;
-		    bit = 0x80 >> (gx&7);
-#ifdef DEBUG_OFF
-		    if ( (gmatrices[idx].buffer[gy*gmatrices[idx].pitch+byte]&bit) )
-			printf("*");
-		    else
-			printf(".");
-#endif
-		    if ( (gmatrices[idx].buffer[gy*gmatrices[idx].pitch+byte]&bit) )
-		    {
-			// set the pixel[mx+gx|my+gy] inside the matrix and leave
-			// pixel[mx+gx+1|my+gy] untouched.
-			mbyte = ((mx+gx)*2) / 8;
-			mbit = 0x80 >> (((mx+gx)*2)&7);
-			offs = ((fnt->matrix_pitch)*(my+gy)+mbyte);
-			if ( offs >= fnt->matrix_size )
-			{
 #ifdef DEBUG
-			    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d] (absolute %d|%d)! (%d > %d)\n",
-			            MODULE_NAME,idx,gx,gy,(mx+gx)*2,(my+gy),offs,fnt->matrix_size);
-#else
-			    fprintf(stderr,"[%s] fatal: generate: #%d access out of buffer for pixel[%d|%d]!\n",
-			            MODULE_NAME,idx,gx,gy);
-#endif
-			    return false;
-			}
-			offs += (fnt->matrix_size) * idx;
-			fnt->buffer[offs] |= mbit;
-		    }
-		}
-#ifdef DEBUG_OFF
-		printf("\n");
-#endif
-	    }
-#ifdef DEBUG_OFF
-	    for ( my=0; my<(fnt->metrics->matrix.height); my++ )
-	    {
-		for ( mx=0; mx<(fnt->metrics->matrix.width); mx++ )
-		{
-		    offs = (fnt->matrix_size) * idx;
-		    mbyte = mx / 8;
-		    mbit = 0x80 >> (mx&7);
-		    offs += (mpitch*(my)+mbyte);
-		    if ( fnt->buffer[offs]&mbit )
-			printf("*");
-		    else
-			printf(".");
-		}
-		printf("\n");
-	    }
+	    fprintf(stderr,"[%s] generate: #%d has no matrix\n",MODULE_NAME,idx);
 #endif
+	    continue;
 	}
+	// render gmatrices[idx] into the matrix of idx
+	mx = gm->offset_x;
+	my = gm->offset_y;
+	matrix = fnt->buffer + (fnt->matrix_size)*idx;
 #ifdef DEBUG
-	else
-	    fprintf(stderr,"[%s] generate: #%d has no matrix\n",MODULE_NAME,idx);
+	fprintf(stderr,"[%s] generate: #%d offs=%d/%d glyph=%d/%d base=%d\n",MODULE_NAME,
+		idx,mx,my,gm->width,gm->height,fnt->metrics->baseline);
 #endif
+	if ( mx<0 || my<0 ||
+	     (fnt->matrix_pitch)*(my+gm->height-1) + ((mx+gm->width-1)*2)/8 >= fnt->matrix_size )
+	{
+	    if ( !blit_pixels(fnt,gm,matrix,idx) )
+		return false;
+	    continue;
+	}
+	for ( gy=0; gy<gm->height; gy++ )
+	{
+	    pos = (fnt->matrix_pitch)*8*(my+gy) + 2*mx;
+	    blit_row(matrix+pos/8,pos&7,gm->buffer+gy*gm->pitch,gm->width);
+	}
     }
 
-    return true;
+    return rotate_matrices(fnt,2) && pack_matrices(fnt);
 }
 
 
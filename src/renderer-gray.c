@@ -0,0 +1,314 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: renderer-gray.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:31:59 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Antialiased renderers with 4 and 8 bits for each pixel ("4bit", "8bit").
+ * The glyphs are rasterized with 8 bit coverage and corrected by the gamma
+ * table of the render options (see --gamma). The pixels are packed from the
+ * MSB, so with 4 bits the left pixel is the high nibble. 0 is background,
+ * the highest value is full coverage.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <string.h>
+
+#define __RENDERER_GRAY_C__
+#include "fontgen.h"
+#include "renderer-gray.h"
+#include "rotate.h"
+#include "pack.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MODULE_NAME "gray"
+
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static t_renderer_plugin plugin_4bit;
+static t_renderer_plugin plugin_8bit;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init_4bit ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
+static bool init_8bit ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars );
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars, int bits );
+static bool generate_4bit ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
+static bool generate_8bit ( t_font_definition *fnt, const t_glyph_matrix *gmatrices );
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices, int bits );
+static bool done ( t_font_definition *fnt );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+const t_renderer_plugin* renderer_4bit_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] renderer_4bit_creator: create renderer.\n",MODULE_NAME);
+    }
+    plugin_4bit.done = done;
+    plugin_4bit.generate = generate_4bit;
+    plugin_4bit.init = init_4bit;
+    plugin_4bit.gray = true;
+    return &plugin_4bit;
+}
+
+const t_renderer_plugin* renderer_8bit_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] renderer_8bit_creator: create renderer.\n",MODULE_NAME);
+    }
+    plugin_8bit.done = done;
+    plugin_8bit.generate = generate_8bit;
+    plugin_8bit.init = init_8bit;
+    plugin_8bit.gray = true;
+    return &plugin_8bit;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init_4bit ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars )
+{
+    return init_font_definition(fnt,metrics,chars,4);
+}
+
+static bool init_8bit ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars )
+{
+    return init_font_definition(fnt,metrics,chars,8);
+}
+
+static bool generate_4bit ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
+{
+    return generate(fnt,gmatrices,4);
+}
+
+static bool generate_8bit ( t_font_definition *fnt, const t_glyph_matrix *gmatrices )
+{
+    return generate(fnt,gmatrices,8);
+}
+
+/* Initialize the passed font definition \c fnt for a renderer with \c bits
+ * per pixel. The metrics of the generated glyphs is passed in \c metrics.
+ * Here we have to prepare the rendering of the glyph bitmaps into the final
+ * matrix bitmaps.
+ */
+static bool init_font_definition ( t_font_definition *fnt, const t_font_metrics *metrics, const t_char_set *chars, int bits )
+{
+    int sz;
+
+    if ( !fnt || !metrics || !chars || !chars->num_ranges || !fnt->options )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init_font_definition: called for %d bits\n",MODULE_NAME,bits);
+
+    /* Remember the font metrics and the character set. There is one glyph
+     * for each code point.
+     */
+    fnt->metrics = metrics;
+    fnt->chars = chars;
+    fnt->first = chars->ranges[0].first;
+    fnt->num = chars->num;
+    if ( fnt->num <= 0 )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: invalid number of entries (%d)\n",MODULE_NAME,fnt->num);
+	return false;
+    }
+
+    /* fill the renderer related values
+     */
+    snprintf(fnt->renderer,MAXNAME,"%dbit",bits); fnt->renderer[MAXNAME]='\0';
+    fnt->matrix_width = bits*(metrics->matrix.width);
+    fnt->matrix_height = metrics->matrix.height;
+
+    /* calculate the number of bytes used to store a row inside the buffer.
+     */
+    fnt->matrix_pitch = fnt->matrix_width/8;
+    if ( fnt->matrix_width%8 )
+	fnt->matrix_pitch++;
+    fnt->matrix_stride = 8*(fnt->matrix_pitch);
+    fnt->matrix_size = fnt->matrix_pitch * fnt->matrix_height;
+
+    // allocate buffer for all data bytes of the final matrices
+    sz = (fnt->matrix_size)*(fnt->num)*sizeof(uint8_t);
+    fnt->buffer = malloc(sz);
+    if ( !fnt->buffer )
+    {
+	fprintf(stderr,"[%s] error: init_font_definition: buffer allocation failed (%d)\n",MODULE_NAME,sz);
+	return false;
+    }
+    memset(fnt->buffer,0,sz);
+#ifdef DEBUG
+    fprintf(stderr,"[%s] init_font_definition: width %d needs %d bytes. buffer-size=%d num=%d alloc=%d\n",MODULE_NAME,
+	    metrics->matrix.width,fnt->matrix_pitch,fnt->matrix_size,fnt->num,sz);
+#endif
+    return true;
+}
+
+/* Store the gamma corrected coverage of the glyph bitmaps with \c bits (4 or
+ * 8) per pixel in the matrices of \c fnt->buffer. The glyph bitmaps have one
+ * byte for each pixel. The packed value of each coverage value is taken from
+ * a table build from the gamma table of \c fnt->options. The visible part of
+ * a glyph is calculated once, pixels outside of the matrix are clipped.
+ *
+ * NOTE: an empty glyph matrix leads to a size (\c sz_buffer in \c gmatrices)
+ * of 0 and a buffer pointer (\c buffer in \c gmatrices) of NULL!
+ *
+ * @param fnt
+ * @param gmatrices the array with all glyph data and the (reduced) glyph matrix
+ */
+static bool generate ( t_font_definition *fnt, const t_glyph_matrix *gmatrices, int bits )
+{
+    uint8_t values[256];		// packed value of each coverage value
+    const t_glyph_matrix *gm;
+    const uint8_t *src;			// row of the glyph bitmap
+    uint8_t *dst;			// row of the matrix
+    int idx;				// index into gmatrices[]
+    int gx, gy;				// pixel coordinates inside the glyph
+    int x0, x1, y0, y1;			// visible part of the glyph
+    int mx;				// pixel column inside the output matrix
+    int maxval;
+    int c;
+
+    if ( !fnt || !gmatrices || (bits!=4 && bits!=8) )
+    {
+	fprintf(stderr,"[%s] error: generate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] generate: called\n",MODULE_NAME);
+
+    maxval = (1<<bits) - 1;
+    for ( c=0; c<256; c++ )
+	values[c] = (fnt->options->gamma_lut[c]*maxval + 127) / 255;
+
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	gm = &gmatrices[idx];
+	if ( !gm->buffer )
+	{
+#ifdef DEBUG
+	    fprintf(stderr,"[%s] generate: #%d has no matrix\n",MODULE_NAME,idx);
+#endif
+	    continue;
+	}
+#ifdef DEBUG
+	fprintf(stderr,"[%s] generate: #%d offs=%d/%d glyph=%d/%d base=%d\n",MODULE_NAME,
+		idx,gm->offset_x,gm->offset_y,gm->width,gm->height,fnt->metrics->baseline);
+#endif
+	x0 = (gm->offset_x<0) ? -gm->offset_x : 0;
+	x1 = fnt->metrics->matrix.width - gm->offset_x;
+	if ( x1 > gm->width )
+	    x1 = gm->width;
+	y0 = (gm->offset_y<0) ? -gm->offset_y : 0;
+	y1 = fnt->matrix_height - gm->offset_y;
+	if ( y1 > gm->height )
+	    y1 = gm->height;
+	for ( gy=y0; gy<y1; gy++ )
+	{
+	    src = gm->buffer + gy*gm->pitch;
+	    dst = fnt->buffer + (fnt->matrix_size)*idx + (fnt->matrix_pitch)*(gm->offset_y+gy);
+	    if ( bits == 8 )
+	    {
+		for ( gx=x0; gx<x1; gx++ )
+		    dst[gm->offset_x+gx] = values[src[gx]];
+		continue;
+	    }
+	    for ( gx=x0; gx<x1; gx++ )
+	    {
+		mx = gm->offset_x+gx;
+		dst[mx/2] |= values[src[gx]] << ((mx&1)?0:4);
+	    }
+	}
+    }
+
+    return rotate_matrices(fnt,bits) && pack_matrices(fnt);
+}
+
+
+static bool done ( t_font_definition *fnt )
+{
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
+
+    if ( fnt->buffer )
+    {
+	free(fnt->buffer);
+	fnt->buffer = NULL;
+    }
+
+    return true;
+}
+
+
+
+//}}}
+
+/* ==[End of file]========================================================== */
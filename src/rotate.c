@@ -0,0 +1,231 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: rotate.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:36:18 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ *
+ * Rotation of the rendered matrices (see --rotate). The renderers with row
+ * major matrices call rotate_matrices() at the end of generate(). The matrices
+ * are rotated clockwise and the geometry of the font definition is updated,
+ * so the writers see the rotated matrices only.
+ *
+ * A rotation by 90 degrees is a transposition of the matrix, which reads the
+ * rows of the source bottom up. 270 degrees writes the rows of the result
+ * bottom up instead, 180 degrees are two rotations by 90 degrees. The matrix
+ * is transposed in blocks of 8 bits x 8/bits rows, so one block is one word.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __ROTATE_C__
+#include "fontgen.h"
+#include "rotate.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool transpose_matrices ( t_font_definition *fnt, int bits, bool flip_src, bool flip_dst );
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+/* Rotate all matrices of \c fnt with \c bits (1, 2, 4 or 8) per pixel by
+ * the rotation of the render options. The buffer is replaced and
+ * \c matrix_width, \c matrix_height, \c matrix_pitch, \c matrix_stride and
+ * \c matrix_size are set to the rotated geometry.
+ */
+bool rotate_matrices ( t_font_definition *fnt, int bits )
+{
+    if ( !fnt || !fnt->buffer || (bits!=1 && bits!=2 && bits!=4 && bits!=8) )
+    {
+	fprintf(stderr,"error: rotate_matrices: illegal parameters\n");
+	return false;
+    }
+    if ( !fnt->options )
+	return true;
+    switch ( fnt->options->rotation )
+    {
+	case 0:
+	    return true;
+	case 90:
+	    return transpose_matrices(fnt,bits,true,false);
+	case 180:
+	    return transpose_matrices(fnt,bits,true,false) &&
+		   transpose_matrices(fnt,bits,true,false);
+	case 270:
+	    return transpose_matrices(fnt,bits,false,true);
+    }
+    fprintf(stderr,"error: rotate_matrices: invalid rotation %d\n",fnt->options->rotation);
+    return false;
+}
+
+/* Transpose the block \c x of 8/bits rows with 8/bits pixels. Row i is the
+ * byte i counted from the MSB of the block, the first pixel of a row is the
+ * MSB of the byte. The blocks of pixels are swapped like with a 8x8 bit
+ * transposition, starting with single pixels. With \c bits 1 this is the
+ * plain 8x8 bit transposition, which the renderer 1bit-vpage uses too.
+ */
+uint64_t transpose_block ( uint64_t x, int bits )
+{
+    uint64_t t;
+
+    switch ( bits )
+    {
+	case 1:
+	    t = (x ^ (x >> 7)) & 0x00AA00AA00AA00AAULL;
+	    x = x ^ t ^ (t << 7);
+	    t = (x ^ (x >> 14)) & 0x0000CCCC0000CCCCULL;
+	    x = x ^ t ^ (t << 14);
+	    t = (x ^ (x >> 28)) & 0x00000000F0F0F0F0ULL;
+	    x = x ^ t ^ (t << 28);
+	    break;
+	case 2:
+	    t = (x ^ (x >> 6)) & 0x00CC00CCULL;
+	    x = x ^ t ^ (t << 6);
+	    t = (x ^ (x >> 12)) & 0x0000F0F0ULL;
+	    x = x ^ t ^ (t << 12);
+	    break;
+	case 4:
+	    t = (x ^ (x >> 4)) & 0x00F0ULL;
+	    x = x ^ t ^ (t << 4);
+	    break;
+    }
+    return x;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+/* Transpose all matrices of \c fnt. The pixel (x|y) of the result is the
+ * pixel (y|x) of the source. If \c flip_src is set, the rows of the source
+ * are read bottom up, if \c flip_dst is set, the rows of the result are
+ * written bottom up.
+ */
+static bool transpose_matrices ( t_font_definition *fnt, int bits, bool flip_src, bool flip_dst )
+{
+    const uint8_t *src;
+    uint8_t *dst;
+    uint8_t *buffer;
+    uint64_t x;
+    int width, height;			// size of the source in pixels
+    int pitch, size;			// geometry of the result
+    int k;				// pixels per byte = rows per block
+    int bx, by;				// byte column of the source / the result
+    int idx, i, y;
+
+    k = 8/bits;
+    width = fnt->matrix_width/bits;
+    height = fnt->matrix_height;
+    pitch = (height+k-1)/k;
+    size = pitch*width;
+    buffer = calloc(fnt->num,size);
+    if ( !buffer )
+    {
+	fprintf(stderr,"error: transpose_matrices: memory allocation failed\n");
+	return false;
+    }
+
+    for ( idx=0; idx<fnt->num; idx++ )
+    {
+	src = fnt->buffer + (fnt->matrix_size)*idx;
+	dst = buffer + size*idx;
+	for ( by=0; by<pitch; by++ )
+	{
+	    for ( bx=0; bx<(fnt->matrix_pitch); bx++ )
+	    {
+		// rows by*k.. of the source, the first one is the MSB of x
+		x = 0;
+		for ( i=0; i<k; i++ )
+		{
+		    y = by*k+i;
+		    x <<= 8;
+		    if ( y < height )
+			x |= src[(fnt->matrix_pitch)*(flip_src?height-1-y:y) + bx];
+		}
+		if ( !x )
+		    continue;
+		x = transpose_block(x,bits);
+		// the MSB of x is row bx*k of the result
+		for ( i=0; i<k && bx*k+i<width; i++ )
+		{
+		    y = bx*k+i;
+		    dst[pitch*(flip_dst?width-1-y:y) + by] = (uint8_t)(x >> (8*(k-1-i)));
+		}
+	    }
+	}
+    }
+
+    free(fnt->buffer);
+    fnt->buffer = buffer;
+    fnt->matrix_width = height*bits;
+    fnt->matrix_height = width;
+    fnt->matrix_pitch = pitch;
+    fnt->matrix_stride = 8*pitch;
+    fnt->matrix_size = size;
+    return true;
+}
+
+//}}}
+
+/* ==[End of file]========================================================== */
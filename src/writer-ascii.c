@@ -23,6 +23,7 @@
 
 #define __WRITER_ASCII_C__
 #include "fontgen.h"
+#include "charset.h"
 
 
 /*+=========================================================================+*/
@@ -62,6 +63,7 @@ static t_writer_plugin this_plugin;
 
 static char output_file[MAXPATH+1] = {""};
 static FILE *output = NULL;
+static bool complete = false;		// create() has written all data
 
 
 //}}}
@@ -74,6 +76,9 @@ static FILE *output = NULL;
 static bool init ( t_font_definition *fnt, const char *filename );
 static bool create ( t_font_definition *fnt );
 static bool done ( t_font_definition *fnt );
+static bool uptodate ( t_font_definition *fnt, const char *filename );
+static void create_output_filename ( t_font_definition *fnt , const char *filename );
+static bool create_boxes ( t_font_definition *fnt );
 
 
 //}}}
@@ -92,6 +97,7 @@ const t_writer_plugin* writer_ascii_creator ( void )
     this_plugin.done = done;
     this_plugin.create = create;
     this_plugin.init = init;
+    this_plugin.uptodate = uptodate;
     return &this_plugin;
 }
 
@@ -125,23 +131,9 @@ static bool init ( t_font_definition *fnt, const char *filename )
     if ( is_verbose() )
 	fprintf(stderr,"[%s] init: called\n",MODULE_NAME);
 
-    if ( filename[0] == '\0')
-    {
-	if ( is_verbose() )
-	    fprintf(stderr,"[%s] init: creating output filename...\n",MODULE_NAME);
-	snprintf(output_file,MAXPATH,"%s_%d_%dx%d.txt",
-		 fnt->metrics->name,
-		 fnt->metrics->pt_size,
-		 fnt->metrics->matrix.width,fnt->metrics->matrix.height);
-    }
-    else
-    {
-	snprintf(output_file,MAXPATH,"%s.txt",filename);
-    }
-    output_file[MAXPATH] = '\0';
-    if ( is_verbose() )
-	fprintf(stderr,"[%s] init: use output filename '%s'\n",MODULE_NAME,output_file);
-    output = fopen(output_file,"w");
+    create_output_filename(fnt,filename);
+    complete = false;
+    output = open_output(output_file,"w");
     if ( !output )
     {
 	fprintf(stderr,"[%s] error: init: unable to create output file '%s'\n",MODULE_NAME,output_file);
@@ -150,7 +142,12 @@ static bool init ( t_font_definition *fnt, const char *filename )
     fprintf(output,"------------------------------------------------------\n");
     fprintf(output,"FONT:\n");
     fprintf(output,"  name:         '%s'\n",fnt->metrics->name);
-    fprintf(output,"  range:        #%d..#%d\n",fnt->first,fnt->first+fnt->num-1);
+    if ( fnt->chars->num_ranges > 1 )
+	fprintf(output,"  range:        #%d..#%d, %d glyphs in %d ranges\n",fnt->first,
+		charset_used_last(fnt->chars,fnt->chars->num_ranges-1),fnt->num-1,
+		charset_used_ranges(fnt->chars));
+    else
+	fprintf(output,"  range:        #%d..#%d\n",fnt->first,fnt->chars->ranges[0].last);
     fprintf(output,"  size:         %d pt\n",fnt->metrics->pt_size);
     if ( fnt->metrics->hdpi )
 	fprintf(output,"  dpi:          %d x %d\n",fnt->metrics->hdpi,fnt->metrics->dpi);
@@ -158,6 +155,7 @@ static bool init ( t_font_definition *fnt, const char *filename )
 	fprintf(output,"  dpi:          %d\n",fnt->metrics->dpi);
     fprintf(output,"  matrix:       %d x %d\n",fnt->matrix_width,fnt->matrix_height);
     fprintf(output,"  renderer:     '%s'\n",fnt->renderer);
+    fprintf(output,"  " HASH_FORMAT "\n",(unsigned long long)fnt->hash);
     fprintf(output,"GLYPH:\n");
     fprintf(output,"  glyph-matrix: %d x %d\n",fnt->metrics->matrix.width,fnt->metrics->matrix.height);
     fprintf(output,"  nl-height:    %d\n",fnt->metrics->absolute_height);
@@ -171,10 +169,44 @@ static bool init ( t_font_definition *fnt, const char *filename )
     return true;
 }
 
+static void create_output_filename ( t_font_definition *fnt , const char *filename )
+{
+    if ( filename[0] == '\0')
+    {
+	if ( is_verbose() )
+	    fprintf(stderr,"[%s] init: creating output filename...\n",MODULE_NAME);
+	snprintf(output_file,MAXPATH,"%s_%d_%dx%d.txt",
+		 fnt->metrics->name,
+		 fnt->metrics->pt_size,
+		 fnt->metrics->matrix.width,fnt->metrics->matrix.height);
+    }
+    else
+    {
+	snprintf(output_file,MAXPATH,"%s.txt",filename);
+    }
+    output_file[MAXPATH] = '\0';
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init: use output filename '%s'\n",MODULE_NAME,output_file);
+}
+
+static bool uptodate ( t_font_definition *fnt, const char *filename )
+{
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: uptodate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    create_output_filename(fnt,filename);
+    return check_file_hash(output_file,fnt->hash);
+}
+
 static bool create ( t_font_definition *fnt )
 {
     int offs;			// offset info buffer of matrix data
+#ifdef DEBUG_oof
     int mpitch;			// number of bytes per matrix row
+#endif
+    int mstride;		// number of bits from one matrix row to the next one
     uint8_t mbit;		// bitmask for matrix
     int mbyte;			// byte within matrix row
     int mx, my;			// pixel coordinates inside the output matrix
@@ -187,6 +219,11 @@ static bool create ( t_font_definition *fnt )
     }
     if ( is_verbose() )
 	fprintf(stderr,"[%s] create: called\n",MODULE_NAME);
+    if ( fnt->boxes )
+    {
+	complete = create_boxes(fnt);
+	return complete;
+    }
 
 #ifdef DEBUG_oof
     /* calculate the number of bytes used to store a row inside the buffer.
@@ -202,13 +239,13 @@ static bool create ( t_font_definition *fnt )
 	return false;
     }
 #endif
-    mpitch = fnt->matrix_pitch;
+    mstride = fnt->matrix_stride;
 
     /* Walk through the generated character definitions
      */
     for ( idx=0; idx<(fnt->num-1); idx++ )
     {
-	fprintf(output,"----- #%d ------------------ \n",fnt->first+idx);
+	fprintf(output,"----- #%d ------------------ \n",charset_code(fnt->chars,idx));
 
 	/* And dump the matrix of each character. The baseline is marked too.
 	 */
@@ -216,10 +253,10 @@ static bool create ( t_font_definition *fnt )
 	{
 	    for ( mx=0; mx<(fnt->matrix_width); mx++ )
 	    {
-		offs = (fnt->matrix_size) * idx;
-		mbyte = mx / 8;
-		mbit = 0x80 >> (mx&7);
-		offs += (mpitch*(my)+mbyte);
+		offs = (fnt->matrix_size) * (fnt->glyph_map[idx]);
+		mbyte = (mstride*my + mx) / 8;
+		mbit = 0x80 >> ((mstride*my + mx)&7);
+		offs += mbyte;
 		if ( fnt->buffer[offs]&mbit )
 		{
 		    // most important part... a bit is set!
@@ -236,11 +273,47 @@ static bool create ( t_font_definition *fnt )
 	}
     }
 
+    complete = true;
+    return true;
+}
+
+/* Dump the ink boxes of a proportional font. The position of each box and
+ * the advance are written above the bitmap.
+ */
+static bool create_boxes ( t_font_definition *fnt )
+{
+    const t_glyph_box *box;
+    const uint8_t *bitmap;
+    int bit;			// bit of the pixel inside the bitmap
+    int mx, my;			// pixel coordinates inside the box
+    int idx;			// index into the boxes
+
+    for ( idx=0; idx<(fnt->num-1); idx++ )
+    {
+	box = &fnt->boxes[fnt->glyph_map[idx]];
+	fprintf(output,"----- #%d ------------------ \n",charset_code(fnt->chars,idx));
+	fprintf(output,"box %dx%d at %d/%d, advance %d\n",box->width,box->height,box->x,box->y,box->advance);
+	for ( my=0; my<(box->height); my++ )
+	{
+	    bitmap = fnt->buffer + box->offset;
+	    for ( mx=0; mx<(box->width); mx++ )
+	    {
+		bit = (box->stride)*my + mx;
+		fprintf(output,"%c",(bitmap[bit/8]&(0x80>>(bit&7)))?'*':'.');
+	    }
+	    if ( box->y+my == (fnt->metrics->matrix.height + fnt->metrics->baseline -1) )
+		fprintf(output,"    ____");
+	    fprintf(output,"\n");
+	}
+    }
+
     return true;
 }
 
 static bool done ( t_font_definition *fnt )
 {
+    bool result = true;
+
     if ( !fnt )
     {
 	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
@@ -250,10 +323,14 @@ static bool done ( t_font_definition *fnt )
 	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
     if ( output )
     {
-	fclose(output);
+	if ( !close_output(output,output_file,complete) )
+	{
+	    fprintf(stderr,"[%s] error: done: unable to write '%s'\n",MODULE_NAME,output_file);
+	    result = false;
+	}
 	output = NULL;
     }
-    return true;
+    return result;
 }
 
 
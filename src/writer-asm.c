@@ -0,0 +1,322 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: writer-asm.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:58:18 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ * This "writer" is an alternative to the C file of the c-raw writer. The
+ * glyph data is written unformatted into the file <name>_data.bin, which is
+ * included by a small assembler file <name>.S with .incbin. The header file
+ * is the same as the one of the c-raw writer, so all FONT_xxx defines and
+ * tables are available. The data is in the section of --section (default
+ * ".rodata.fonts").
+ *
+ * Sample:
+ *
+ *  ,--------------------------
+ *  |#include "Inconsolata_Regular_17_9x18.h"
+ *  |extern const uint8_t Inconsolata_Regular_17_9x18_data[FONT_BUFFER_SIZE];
+ *  `--------------------------
+ *
+ * Assembling .incbin is much faster than compiling the hex literals of a
+ * large font. The .bin file is searched by the assembler in the include
+ * path, so the directory of the files must be passed with -I if it is not
+ * the current one.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __WRITER_ASM_C__
+#include "fontgen.h"
+#include "writer-c-raw.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MODULE_NAME "asm"
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+
+static t_writer_plugin this_plugin;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static char symbol_name[MAXPATH+2] = {""};	// one more for a leading '_'
+static char output_file[MAXPATH+1] = {""};
+static FILE *output = NULL;
+static bool complete = false;		// create() has written all data
+
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init ( t_font_definition *fnt, const char *filename );
+static bool create ( t_font_definition *fnt );
+static bool done ( t_font_definition *fnt );
+static bool uptodate ( t_font_definition *fnt, const char *filename );
+static void create_output_filename ( t_font_definition *fnt , const char *filename, const char* extension );
+static bool write_data_file ( t_font_definition *fnt );
+
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+const t_writer_plugin* writer_asm_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] writer_asm_creator: create writer.\n",MODULE_NAME);
+    }
+    this_plugin.done = done;
+    this_plugin.create = create;
+    this_plugin.init = init;
+    this_plugin.uptodate = uptodate;
+    return &this_plugin;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init ( t_font_definition *fnt, const char *filename )
+{
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: init: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init: called\n",MODULE_NAME);
+
+    if ( !c_raw_write_header(fnt,filename) )
+	return false;
+
+    create_output_filename(fnt,filename,"S");
+    complete = false;
+    output = open_output(output_file,"w");
+    if ( !output )
+    {
+	fprintf(stderr,"[%s] error: init: unable to create output file '%s'\n",MODULE_NAME,output_file);
+	return false;
+    }
+    return true;
+}
+
+/* The .bin file has no hash. It is written before the assembler file, so
+ * the hash of the assembler file covers it.
+ */
+static bool uptodate ( t_font_definition *fnt, const char *filename )
+{
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: uptodate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    create_output_filename(fnt,filename,"h");
+    if ( !check_file_hash(output_file,fnt->hash) )
+	return false;
+    create_output_filename(fnt,filename,"S");
+    return check_file_hash(output_file,fnt->hash);
+}
+
+/* The symbol of the data is the basename of the files. Like the defines of
+ * the c-raw writer, every character which can't be used in a C name is
+ * replaced by '_'.
+ */
+static void create_output_filename ( t_font_definition *fnt , const char *filename, const char* extension )
+{
+    const char *base;
+    char *p;
+
+    if ( filename[0] == '\0')
+    {
+	if ( is_verbose() )
+	    fprintf(stderr,"[%s] init: creating output filename...\n",MODULE_NAME);
+	snprintf(output_file,MAXPATH,"%s_%d_%dx%d.%s",
+		 fnt->metrics->name,
+		 fnt->metrics->pt_size,
+		 fnt->metrics->matrix.width,fnt->metrics->matrix.height,
+		 extension);
+    }
+    else
+    {
+	snprintf(output_file,MAXPATH,"%s.%s",filename,extension);
+    }
+    output_file[MAXPATH] = '\0';
+
+    // only the last part of the path without the extension
+    base = strrchr(output_file,'/');
+    base = base ? base+1 : output_file;
+    p = symbol_name;
+    if ( *base>='0' && *base<='9' )
+	*p++ = '_';
+    strcpy(p,base);
+    symbol_name[strlen(symbol_name)-strlen(extension)-1] = '\0';
+    for ( ; *p; p++ )
+    {
+	if ( !((*p>='a' && *p<='z') || (*p>='A' && *p<='Z') || (*p>='0' && *p<='9')) )
+	    *p = '_';
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init: use output filename '%s'\n",MODULE_NAME,output_file);
+}
+
+/* Write the .bin file and the assembler file which includes it. The output
+ * filename is still the one of the assembler file.
+ */
+static bool create ( t_font_definition *fnt )
+{
+    const char *section;
+    char *bin_name;
+
+    if ( !fnt || !output )
+    {
+	fprintf(stderr,"[%s] error: create: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] create: called\n",MODULE_NAME);
+
+    if ( !write_data_file(fnt) )
+	return false;
+    bin_name = strrchr(output_file,'/');
+    bin_name = bin_name ? bin_name+1 : output_file;
+    section = (fnt->options && fnt->options->section[0]) ? fnt->options->section : DEFAULT_SECTION;
+
+    fprintf(output,"/* ------------------------------------------------------\n");
+    fprintf(output," * FONT:\n");
+    fprintf(output," *   name:         '%s'\n",fnt->metrics->name);
+    fprintf(output," *   size:         %d pt\n",fnt->metrics->pt_size);
+    fprintf(output," *   matrix:       %d x %d\n",fnt->matrix_width,fnt->matrix_height);
+    fprintf(output," *   renderer:     '%s'\n",fnt->renderer);
+    fprintf(output," *   " HASH_FORMAT "\n",(unsigned long long)fnt->hash);
+    fprintf(output," * ------------------------------------------------------\n */\n\n");
+    fprintf(output,"\t.section %s,\"a\"\n",section);
+    fprintf(output,"\t.balign 4\n");
+    fprintf(output,"\t.global %s_data\n",symbol_name);
+    fprintf(output,"\t.type %s_data, %%object\n",symbol_name);
+    fprintf(output,"%s_data:\n",symbol_name);
+    fprintf(output,"\t.incbin \"%.*s_data.bin\"\n",(int)(strlen(bin_name)-2),bin_name);
+    fprintf(output,"\t.size %s_data, . - %s_data\n",symbol_name,symbol_name);
+    if ( fprintf(output,"\n\t.section .note.GNU-stack,\"\",%%progbits\n") < 0 )
+    {
+	fprintf(stderr,"[%s] error: create: unable to write '%s'\n",MODULE_NAME,output_file);
+	return false;
+    }
+    complete = true;
+    return true;
+}
+
+/* The data is the same as the one of the C file of the c-raw writer. Its
+ * size is FONT_BUFFER_SIZE.
+ */
+static bool write_data_file ( t_font_definition *fnt )
+{
+    const uint8_t *data;
+    char name[MAXPATH+1];
+    FILE *f;
+    int size;
+    int n;
+
+    data = fnt->compressed ? fnt->compressed : fnt->buffer;
+    size = c_raw_data_size(fnt);
+
+    n = strlen(output_file) - 2;
+    snprintf(name,MAXPATH,"%.*s_data.bin",n,output_file);
+    name[MAXPATH] = '\0';
+    f = open_output(name,"wb");
+    if ( !f )
+    {
+	fprintf(stderr,"[%s] error: create: unable to create output file '%s'\n",MODULE_NAME,name);
+	return false;
+    }
+    n = fwrite(data,1,size,f);
+    if ( !close_output(f,name,n==size) || n!=size )
+    {
+	fprintf(stderr,"[%s] error: create: unable to write '%s'\n",MODULE_NAME,name);
+	return false;
+    }
+    return true;
+}
+
+static bool done ( t_font_definition *fnt )
+{
+    bool result = true;
+
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
+    if ( output )
+    {
+	if ( !close_output(output,output_file,complete) )
+	{
+	    fprintf(stderr,"[%s] error: done: unable to write '%s'\n",MODULE_NAME,output_file);
+	    result = false;
+	}
+	output = NULL;
+    }
+    return result;
+}
+
+
+//}}}
+
+/* ==[End of file]========================================================== */
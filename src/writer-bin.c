@@ -0,0 +1,470 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: writer-bin.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:52:26 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ * This "writer" creates a binary file, which can be stored in a flash or a
+ * filesystem and used without any parsing. All values are little endian. The
+ * file starts with a header of 96 bytes. The other parts are found by their
+ * offsets in the header and start at a multiple of 4 bytes. An offset of 0
+ * means that the part is not in the file.
+ *
+ *   offs  type       name
+ *   ----  ---------  ------------------------------------------------------
+ *     0   char[4]    magic "EFNT"
+ *     4   uint16     version (1)
+ *     6   uint16     size of the header (96)
+ *     8   uint32     flags (see BIN_xxx)
+ *    12   uint32     size of the file
+ *    16   uint64     hash of all inputs
+ *    24   char[16]   name of the renderer (zero padded)
+ *    40   uint16     matrix width
+ *    42   uint16     matrix height
+ *    44   uint16     matrix pitch (bytes per row, 0 if packed)
+ *    46   uint16     matrix stride (bits from one row to the next one)
+ *    48   uint32     matrix size (bytes per matrix)
+ *    52   uint32     number of characters (n)
+ *    56   uint32     number of stored glyphs (g)
+ *    60   uint16     number of ranges
+ *    62   uint8      alignment of packed glyphs (0 if not packed)
+ *    63   uint8      rotation / 90
+ *    64   int16      baseline (<=0)
+ *    66   uint16     line height
+ *    68   uint16     max. ascent
+ *    70   uint16     max. descent
+ *    72   uint32     offset of the ranges:   {uint32 first, last, index}
+ *    76   uint32     offset of the index:    uint16 glyph of each character
+ *    80   uint32     offset of the boxes:    {uint32 offset; uint8 width,
+ *                                             height; int8 x, y; uint8
+ *                                             advance, 0, 0, 0}
+ *    84   uint32     offset of the offsets:  uint32 start of each compressed
+ *                                            glyph and the end of the data
+ *    88   uint32     offset of the data
+ *    92   uint32     size of the data
+ *
+ * The character c in the range r is the character i = r.index+c-r.first.
+ * Its glyph g is index[i] (or i, if there is no index). The matrix of g
+ * starts at g*matrix size inside the data. A proportional font has a box for
+ * each glyph, the next box ends the bitmap. The compressed glyph g uses the
+ * bytes offsets[g] to offsets[g+1] of the data (see the decoder of the c-raw
+ * writer). So the index has n entries, there are g+1 boxes and g+1 offsets.
+ * The unused last glyph of the other writers isn't stored.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __WRITER_BIN_C__
+#include "fontgen.h"
+#include "charset.h"
+#include "writer-bin.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MODULE_NAME "bin"
+
+#define BIN_RANGE_SIZE  12	// size of one entry of the ranges
+#define BIN_BOX_SIZE    12	// size of one entry of the boxes
+#define BIN_RENDERER    16	// size of the renderer name
+
+/* The flags of the header
+ */
+#define BIN_PROPORTIONAL 0x0001	// the glyphs have boxes
+#define BIN_PACKED       0x0002	// the rows of the glyphs are packed
+#define BIN_COMPRESSED   0x0004	// the glyphs are RLE compressed
+#define BIN_INDEX        0x0008	// the characters are mapped by the index
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+
+#define ALIGN4(n) (((n)+3)&~3)
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+
+static t_writer_plugin this_plugin;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static char output_file[MAXPATH+1] = {""};
+static FILE *output = NULL;
+static bool complete = false;		// create() has written all data
+
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init ( t_font_definition *fnt, const char *filename );
+static bool create ( t_font_definition *fnt );
+static bool done ( t_font_definition *fnt );
+static bool uptodate ( t_font_definition *fnt, const char *filename );
+static void create_output_filename ( t_font_definition *fnt , const char *filename );
+static void write_header ( t_font_definition *fnt, uint8_t *image, uint32_t flags, const uint32_t *parts, int size );
+static void put16 ( uint8_t *p, unsigned value );
+static void put32 ( uint8_t *p, uint32_t value );
+static uint64_t get64 ( const uint8_t *p );
+
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+const t_writer_plugin* writer_bin_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] writer_bin_creator: create writer.\n",MODULE_NAME);
+    }
+    this_plugin.done = done;
+    this_plugin.create = create;
+    this_plugin.init = init;
+    this_plugin.uptodate = uptodate;
+    return &this_plugin;
+}
+
+/* Build the complete file in memory. The parts are stored in the order of
+ * their offsets in the header. The returned image must be freed by the
+ * caller. The elf writer uses the same image.
+ */
+uint8_t *bin_create_image ( t_font_definition *fnt, int *size )
+{
+    const t_char_range *r;
+    const t_glyph_box *b;
+    const uint8_t *data;
+    uint32_t parts[6];		// offsets of ranges, index, boxes, offsets, data and the data size
+    uint32_t flags = 0;
+    uint8_t *image;
+    uint8_t *p;
+    int i;
+
+    if ( !fnt || !fnt->buffer || !size )
+    {
+	fprintf(stderr,"[%s] error: bin_create_image: illegal parameters\n",MODULE_NAME);
+	return NULL;
+    }
+    if ( fnt->boxes )
+	flags |= BIN_PROPORTIONAL;
+    if ( fnt->options && fnt->options->packing )
+	flags |= BIN_PACKED;
+    if ( fnt->compressed )
+	flags |= BIN_COMPRESSED;
+    if ( fnt->options && fnt->options->dedup )
+	flags |= BIN_INDEX;
+    if ( (flags&BIN_INDEX) && fnt->num_glyphs > 0x10000 )
+    {
+	fprintf(stderr,"[%s] error: bin_create_image: too many glyphs for the index (%d)\n",MODULE_NAME,fnt->num_glyphs);
+	return NULL;
+    }
+
+    /* Calculate the offsets of the parts.
+     */
+    if ( fnt->compressed )
+    {
+	data = fnt->compressed;
+	parts[5] = fnt->compressed_offsets[fnt->num_glyphs-1];
+    }
+    else
+    {
+	data = fnt->buffer;
+	parts[5] = fnt->boxes ? fnt->buffer_size : (fnt->matrix_size)*(fnt->num_glyphs-1);
+    }
+    *size = BIN_HEADER_SIZE;
+    parts[0] = *size;
+    *size += BIN_RANGE_SIZE*charset_used_ranges(fnt->chars);
+    parts[1] = (flags&BIN_INDEX) ? *size : 0;
+    if ( flags&BIN_INDEX )
+	*size = ALIGN4(*size + 2*(fnt->num-1));
+    parts[2] = fnt->boxes ? *size : 0;
+    if ( fnt->boxes )
+	*size += BIN_BOX_SIZE*(fnt->num_glyphs);
+    parts[3] = fnt->compressed ? *size : 0;
+    if ( fnt->compressed )
+	*size += 4*(fnt->num_glyphs);
+    parts[4] = *size;
+    *size = ALIGN4(*size + parts[5]);
+
+    image = calloc(*size,sizeof(uint8_t));
+    if ( !image )
+    {
+	fprintf(stderr,"[%s] error: bin_create_image: memory allocation failed\n",MODULE_NAME);
+	return NULL;
+    }
+    write_header(fnt,image,flags,parts,*size);
+
+    for ( i=0; i<charset_used_ranges(fnt->chars); i++ )
+    {
+	r = &fnt->chars->ranges[i];
+	p = image + parts[0] + BIN_RANGE_SIZE*i;
+	put32(p,r->first);
+	put32(p+4,charset_used_last(fnt->chars,i));
+	put32(p+8,r->index);
+    }
+    if ( flags&BIN_INDEX )
+    {
+	for ( i=0; i<fnt->num-1; i++ )
+	    put16(image+parts[1]+2*i,fnt->glyph_map[i]);
+    }
+    if ( fnt->boxes )
+    {
+	for ( i=0; i<fnt->num_glyphs; i++ )
+	{
+	    b = &fnt->boxes[i];
+	    if ( b->width>255 || b->height>255 || b->advance<0 || b->advance>255 ||
+		 b->x<-128 || b->x>127 || b->y<-128 || b->y>127 )
+	    {
+		fprintf(stderr,"[%s] error: glyph #%d doesn't fit into the boxes\n",MODULE_NAME,
+			charset_code(fnt->chars,fnt->glyph_chars[i]));
+		free(image);
+		return NULL;
+	    }
+	    p = image + parts[2] + BIN_BOX_SIZE*i;
+	    put32(p,b->offset);
+	    p[4] = b->width;
+	    p[5] = b->height;
+	    p[6] = (uint8_t)(int8_t)b->x;
+	    p[7] = (uint8_t)(int8_t)b->y;
+	    p[8] = b->advance;
+	}
+    }
+    if ( fnt->compressed )
+    {
+	for ( i=0; i<fnt->num_glyphs; i++ )
+	    put32(image+parts[3]+4*i,fnt->compressed_offsets[i]);
+    }
+    memcpy(image+parts[4],data,parts[5]);
+    return image;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init ( t_font_definition *fnt, const char *filename )
+{
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: init: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init: called\n",MODULE_NAME);
+
+    create_output_filename(fnt,filename);
+    complete = false;
+    output = open_output(output_file,"wb");
+    if ( !output )
+    {
+	fprintf(stderr,"[%s] error: init: unable to create output file '%s'\n",MODULE_NAME,output_file);
+	return false;
+    }
+    return true;
+}
+
+static void create_output_filename ( t_font_definition *fnt , const char *filename )
+{
+    if ( filename[0] == '\0')
+    {
+	if ( is_verbose() )
+	    fprintf(stderr,"[%s] init: creating output filename...\n",MODULE_NAME);
+	snprintf(output_file,MAXPATH,"%s_%d_%dx%d.bin",
+		 fnt->metrics->name,
+		 fnt->metrics->pt_size,
+		 fnt->metrics->matrix.width,fnt->metrics->matrix.height);
+    }
+    else
+    {
+	snprintf(output_file,MAXPATH,"%s.bin",filename);
+    }
+    output_file[MAXPATH] = '\0';
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init: use output filename '%s'\n",MODULE_NAME,output_file);
+}
+
+/* The hash is stored in the header, so only the header is read. The size of
+ * the file in the header tells if the file is complete.
+ */
+static bool uptodate ( t_font_definition *fnt, const char *filename )
+{
+    uint8_t head[24];
+    bool found = false;
+    FILE *f;
+
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: uptodate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    create_output_filename(fnt,filename);
+    f = fopen(output_file,"rb");
+    if ( !f )
+	return false;
+    if ( fread(head,sizeof(head),1,f)==1 && fseek(f,0,SEEK_END)==0 )
+	found = memcmp(head,BIN_MAGIC,4)==0 && head[4]==BIN_VERSION && head[5]==0 &&
+		get64(head+BIN_HASH_OFFSET)==fnt->hash && (get64(head+8)>>32)==(uint64_t)ftell(f);
+    fclose(f);
+    return found;
+}
+
+static bool create ( t_font_definition *fnt )
+{
+    uint8_t *image;
+    int size;
+
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: create: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] create: called\n",MODULE_NAME);
+
+    image = bin_create_image(fnt,&size);
+    if ( !image )
+	return false;
+    if ( fwrite(image,1,size,output)!=(size_t)size )
+    {
+	fprintf(stderr,"[%s] error: create: unable to write '%s'\n",MODULE_NAME,output_file);
+	free(image);
+	return false;
+    }
+    free(image);
+    complete = true;
+    return true;
+}
+
+/* Fill the header at the start of \c image. \c parts are the offsets of the
+ * parts and the size of the data, \c size is the size of the file.
+ */
+static void write_header ( t_font_definition *fnt, uint8_t *image, uint32_t flags, const uint32_t *parts, int size )
+{
+    const t_font_metrics *m = fnt->metrics;
+    int i;
+
+    memcpy(image,BIN_MAGIC,4);
+    put16(image+4,BIN_VERSION);
+    put16(image+6,BIN_HEADER_SIZE);
+    put32(image+8,flags);
+    put32(image+12,size);
+    put32(image+BIN_HASH_OFFSET,(uint32_t)(fnt->hash));
+    put32(image+BIN_HASH_OFFSET+4,(uint32_t)(fnt->hash>>32));
+    i = strlen(fnt->renderer);
+    memcpy(image+24,fnt->renderer,(i<BIN_RENDERER)?i:BIN_RENDERER-1);
+    put16(image+40,fnt->matrix_width);
+    put16(image+42,fnt->matrix_height);
+    put16(image+44,fnt->matrix_pitch);
+    put16(image+46,fnt->matrix_stride);
+    put32(image+48,fnt->matrix_size);
+    put32(image+52,fnt->num-1);
+    put32(image+56,fnt->num_glyphs-1);
+    put16(image+60,charset_used_ranges(fnt->chars));
+    image[62] = fnt->options ? fnt->options->packing : 0;
+    image[63] = fnt->options ? fnt->options->rotation/90 : 0;
+    put16(image+64,(uint16_t)(int16_t)m->baseline);
+    put16(image+66,m->absolute_height);
+    put16(image+68,m->max_ascent);
+    put16(image+70,m->max_descent);
+    for ( i=0; i<6; i++ )
+	put32(image+BIN_PARTS_OFFSET+4*i,parts[i]);
+}
+
+static bool done ( t_font_definition *fnt )
+{
+    bool result = true;
+
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
+    if ( output )
+    {
+	if ( !close_output(output,output_file,complete) )
+	{
+	    fprintf(stderr,"[%s] error: done: unable to write '%s'\n",MODULE_NAME,output_file);
+	    result = false;
+	}
+	output = NULL;
+    }
+    return result;
+}
+
+static void put16 ( uint8_t *p, unsigned value )
+{
+    p[0] = value & 0xFF;
+    p[1] = (value>>8) & 0xFF;
+}
+
+static void put32 ( uint8_t *p, uint32_t value )
+{
+    put16(p,value & 0xFFFF);
+    put16(p+2,value>>16);
+}
+
+static uint64_t get64 ( const uint8_t *p )
+{
+    uint64_t value = 0;
+    int i;
+
+    for ( i=7; i>=0; i-- )
+	value = (value<<8) | p[i];
+    return value;
+}
+
+
+//}}}
+
+/* ==[End of file]========================================================== */
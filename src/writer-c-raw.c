@@ -25,6 +25,11 @@
  *  |};
  *  `--------------------------
  *
+ * The data of a large font has millions of bytes and pixels. So create()
+ * doesn't use fprintf() for them. The bytes and the bitmap comments are
+ * formatted with lookup tables into a large buffer, which is written with
+ * fwrite() when it is full.
+ *
  * --------------------------------------------------------------------------
  * COMPILER-FLAGS:
  *
@@ -32,6 +37,7 @@
  */
 
 #include <stdio.h>
+#include <string.h>
 #include <unistd.h>
 #include <ctype.h>
 #include <stdint.h>
@@ -39,6 +45,8 @@
 
 #define __WRITER_C_RAW_C__
 #include "fontgen.h"
+#include "charset.h"
+#include "writer-c-raw.h"
 
 
 /*+=========================================================================+*/
@@ -48,6 +56,9 @@
 
 #define MODULE_NAME "c-raw"
 
+#define OUT_BUFFER_SIZE 65536	// size of the buffer used by create()
+#define OUT_RESERVE 64		// max. size of a single out_xxx() call (but out_art)
+
 //}}}
 
 /*             .-----------------------------------------------.             */
@@ -79,7 +90,13 @@ static t_writer_plugin this_plugin;
 static char define_name[MAXPATH+1] = {""};
 static char output_file[MAXPATH+1] = {""};
 static FILE *output = NULL;
+static bool complete = false;		// create() has written all data
 
+static char out_buffer[OUT_BUFFER_SIZE];	// the formatted data of create()
+static int out_len = 0;			// used bytes of out_buffer
+static bool out_error = false;		// a write of out_buffer failed
+static char art_table[256][8];		// the pixels of each byte as '*' and '.'
+static bool art_table_ready = false;
 
 //}}}
 
@@ -93,12 +110,33 @@ static FILE *output = NULL;
 static bool init ( t_font_definition *fnt, const char *filename );
 static bool create ( t_font_definition *fnt );
 static bool done ( t_font_definition *fnt );
+static bool uptodate ( t_font_definition *fnt, const char *filename );
 
 /* local helpers
  */
 static void create_output_filename ( t_font_definition *fnt , const char *filename, const char* extension );
 static bool write_header_file ( t_font_definition *fnt );
 static bool write_file_head ( t_font_definition *fnt );
+static void write_range ( t_font_definition *fnt );
+static void write_range_table ( t_font_definition *fnt );
+static bool write_glyph_table ( t_font_definition *fnt );
+static bool create_boxes ( t_font_definition *fnt );
+static void write_index_table ( t_font_definition *fnt );
+static bool create_compressed ( t_font_definition *fnt );
+static void write_decoder ( t_font_definition *fnt );
+static void write_glyph_head ( t_font_definition *fnt, int idx );
+static void write_bytes ( const uint8_t *data, int n, bool last );
+static void write_art ( t_font_definition *fnt, const uint8_t *bitmap, int width, int height, int stride, int top );
+static bool write_end ( void );
+
+/* the buffered output of create()
+ */
+static void out_reserve ( int n );
+static bool out_flush ( void );
+static void out_text ( const char *text );
+static void out_hex ( uint8_t value, bool comma );
+static void out_art ( const uint8_t *bitmap, int bit, int width );
+static void init_art_table ( void );
 
 
 //}}}
@@ -108,6 +146,46 @@ static bool write_file_head ( t_font_definition *fnt );
 /*`========================================================================='*/
 //{{{
 
+/* Create the header file with the FONT_xxx defines. It is used by the asm
+ * writer too, so both writers share the same definitions.
+ */
+bool c_raw_write_header ( t_font_definition *fnt, const char *filename )
+{
+    create_output_filename(fnt,filename,"h");
+    output = open_output(output_file,"w");
+    if ( !output )
+    {
+	fprintf(stderr,"[%s] error: init: unable to create output file '%s'\n",MODULE_NAME,output_file);
+	return false;
+    }
+    if ( !write_header_file(fnt) )
+    {
+	close_output(output,output_file,false);
+	output = NULL;
+	return false;
+    }
+    if ( !close_output(output,output_file,true) )
+    {
+	fprintf(stderr,"[%s] error: init: unable to write '%s'\n",MODULE_NAME,output_file);
+	output = NULL;
+	return false;
+    }
+    output = NULL;
+    return true;
+}
+
+/* Return the size of the glyph data (FONT_BUFFER_SIZE). The unused last
+ * matrix is counted only for a plain "from..to" font, like it always was.
+ */
+int c_raw_data_size ( const t_font_definition *fnt )
+{
+    if ( fnt->compressed )
+	return fnt->compressed_offsets[fnt->num_glyphs-1];
+    if ( fnt->boxes )
+	return fnt->buffer_size;
+    return (fnt->matrix_size)*(fnt->num_glyphs-fnt->chars->spare)*sizeof(uint8_t);
+}
+
 const t_writer_plugin* writer_c_raw_creator ( void )
 {
     if ( is_verbose() )
@@ -117,6 +195,7 @@ const t_writer_plugin* writer_c_raw_creator ( void )
     this_plugin.done = done;
     this_plugin.create = create;
     this_plugin.init = init;
+    this_plugin.uptodate = uptodate;
     return &this_plugin;
 }
 
@@ -150,27 +229,42 @@ static bool init ( t_font_definition *fnt, const char *filename )
     if ( is_verbose() )
 	fprintf(stderr,"[%s] init: called\n",MODULE_NAME);
 
-    create_output_filename(fnt,filename,"h");
-    output = fopen(output_file,"w");
-    if ( !output )
-    {
-	fprintf(stderr,"[%s] error: init: unable to create output file '%s'\n",MODULE_NAME,output_file);
+    if ( !c_raw_write_header(fnt,filename) )
 	return false;
-    }
-    write_header_file(fnt);
 
     create_output_filename(fnt,filename,"c");
-    output = fopen(output_file,"w");
+    complete = false;
+    output = open_output(output_file,"w");
     if ( !output )
     {
 	fprintf(stderr,"[%s] error: init: unable to create output file '%s'\n",MODULE_NAME,output_file);
 	return false;
     }
     write_file_head(fnt);
+    out_len = 0;
+    out_error = false;
+    if ( !art_table_ready )
+	init_art_table();
 
     return true;
 }
 
+/* Both files must be created from the same inputs.
+ */
+static bool uptodate ( t_font_definition *fnt, const char *filename )
+{
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: uptodate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    create_output_filename(fnt,filename,"h");
+    if ( !check_file_hash(output_file,fnt->hash) )
+	return false;
+    create_output_filename(fnt,filename,"c");
+    return check_file_hash(output_file,fnt->hash);
+}
+
 
 static void create_output_filename ( t_font_definition *fnt , const char *filename, const char* extension )
 {
@@ -224,7 +318,7 @@ static bool write_header_file ( t_font_definition *fnt )
     int rc;
     int sz;
 
-    sz = (fnt->matrix_size)*(fnt->num)*sizeof(uint8_t);
+    sz = c_raw_data_size(fnt);
     rc = fprintf(output,"#ifndef __%s_H__\n",define_name);
     if ( rc < 0 )
 	return false;
@@ -232,7 +326,7 @@ static bool write_header_file ( t_font_definition *fnt )
     fprintf(output,"/* ------------------------------------------------------\n");
     fprintf(output," * FONT:\n");
     fprintf(output," *   name:         '%s'\n",fnt->metrics->name);
-    fprintf(output," *   range:        #%d..#%d\n",fnt->first,fnt->first+fnt->num-1);
+    write_range(fnt);
     fprintf(output," *   size:         %d pt\n",fnt->metrics->pt_size);
     if ( fnt->metrics->hdpi )
 	fprintf(output," *   dpi:          %d x %d\n",fnt->metrics->hdpi,fnt->metrics->dpi);
@@ -240,6 +334,7 @@ static bool write_header_file ( t_font_definition *fnt )
 	fprintf(output," *   dpi:          %d\n",fnt->metrics->dpi);
     fprintf(output," *   matrix:       %d x %d\n",fnt->matrix_width,fnt->matrix_height);
     fprintf(output," *   renderer:     '%s'\n",fnt->renderer);
+    fprintf(output," *   " HASH_FORMAT "\n",(unsigned long long)fnt->hash);
     fprintf(output," * GLYPH:\n");
     fprintf(output," *   glyph-matrix: %d x %d\n",fnt->metrics->matrix.width,fnt->metrics->matrix.height);
     fprintf(output," *   nl-height:    %d\n",fnt->metrics->absolute_height);
@@ -253,12 +348,29 @@ static bool write_header_file ( t_font_definition *fnt )
 
     fprintf(output,"#define FONT_NAME           \"%s\"\n",fnt->metrics->name);
     fprintf(output,"#define FONT_START_WITH     %d\n",fnt->first);
-    fprintf(output,"#define FONT_NUM_CHARS      %d\n",fnt->first+fnt->num-1);
+    fprintf(output,"#define FONT_NUM_CHARS      %d\n",fnt->chars->ranges[fnt->chars->num_ranges-1].last);
     fprintf(output,"#define FONT_GLYPH_WIDTH    %d\n",fnt->metrics->matrix.width);
     fprintf(output,"#define FONT_GLYPH_HEIGHT   %d\n",fnt->metrics->matrix.height);
     fprintf(output,"#define FONT_MATRIX_WIDTH   %d\n",fnt->matrix_width);
     fprintf(output,"#define FONT_MATRIX_HEIGHT  %d\n",fnt->matrix_height);
     fprintf(output,"#define FONT_BUFFER_SIZE    %d\n",sz);
+    if ( fnt->options && fnt->options->packing )
+	fprintf(output,"#define FONT_PACKED         %d\n",fnt->options->packing);
+    if ( !fnt->boxes && !fnt->matrix_pitch )
+	fprintf(output,"#define FONT_MATRIX_STRIDE  %d\n",fnt->matrix_stride);
+    if ( !fnt->boxes && (!fnt->matrix_pitch || fnt->compressed) )
+	fprintf(output,"#define FONT_MATRIX_SIZE    %d\n",fnt->matrix_size);
+    if ( fnt->chars->num_ranges>1 || fnt->chars->spare || fnt->boxes || fnt->compressed ||
+	 (fnt->options && fnt->options->dedup) )
+	fprintf(output,"#define FONT_NUM_GLYPHS     %d\n",fnt->num-1);
+    if ( fnt->chars->num_ranges > 1 )
+	write_range_table(fnt);
+    if ( fnt->boxes && !write_glyph_table(fnt) )
+	return false;
+    if ( fnt->options && fnt->options->dedup )
+	write_index_table(fnt);
+    if ( fnt->compressed )
+	write_decoder(fnt);
 
     fprintf(output,"\n\n#endif // __%s_H__\n",define_name);
     return true;
@@ -273,7 +385,7 @@ static bool write_file_head ( t_font_definition *fnt )
     fprintf(output,"/* ------------------------------------------------------\n");
     fprintf(output," * FONT:\n");
     fprintf(output," *   name:         '%s'\n",fnt->metrics->name);
-    fprintf(output," *   range:        #%d..#%d\n",fnt->first,fnt->first+fnt->num-1);
+    write_range(fnt);
     fprintf(output," *   size:         %d pt\n",fnt->metrics->pt_size);
     if ( fnt->metrics->hdpi )
 	fprintf(output," *   dpi:          %d x %d\n",fnt->metrics->hdpi,fnt->metrics->dpi);
@@ -281,6 +393,7 @@ static bool write_file_head ( t_font_definition *fnt )
 	fprintf(output," *   dpi:          %d\n",fnt->metrics->dpi);
     fprintf(output," *   matrix:       %d x %d\n",fnt->matrix_width,fnt->matrix_height);
     fprintf(output," *   renderer:     '%s'\n",fnt->renderer);
+    fprintf(output," *   " HASH_FORMAT "\n",(unsigned long long)fnt->hash);
     fprintf(output," * GLYPH:\n");
     fprintf(output," *   glyph-matrix: %d x %d\n",fnt->metrics->matrix.width,fnt->metrics->matrix.height);
     fprintf(output," *   nl-height:    %d\n",fnt->metrics->absolute_height);
@@ -295,14 +408,130 @@ static bool write_file_head ( t_font_definition *fnt )
     return true;
 }
 
+/* The range of the character codes inside the comment of both files.
+ */
+static void write_range ( t_font_definition *fnt )
+{
+    if ( fnt->chars->num_ranges > 1 )
+	fprintf(output," *   range:        #%d..#%d, %d glyphs in %d ranges\n",fnt->first,
+		charset_used_last(fnt->chars,fnt->chars->num_ranges-1),fnt->num-1,
+		charset_used_ranges(fnt->chars));
+    else
+	fprintf(output," *   range:        #%d..#%d\n",fnt->first,fnt->chars->ranges[0].last);
+}
+
+/* A sparse character set needs a lookup table code point -> glyph. The table
+ * is written as initializer, like the matrix data:
+ *
+ *  ,--------------------------
+ *  |static const struct { uint32_t first, last, index; } my_ranges[FONT_NUM_RANGES] = FONT_RANGES;
+ *  `--------------------------
+ *
+ * The glyph of the code point c inside of range r is r.index+c-r.first. The
+ * ranges are sorted, so a binary search can be used. The unused last glyph
+ * is not part of the table.
+ */
+static void write_range_table ( t_font_definition *fnt )
+{
+    const t_char_range *r;
+    int num;
+    int i;
+
+    num = charset_used_ranges(fnt->chars);
+    fprintf(output,"#define FONT_NUM_RANGES     %d\n",num);
+    fprintf(output,"#define FONT_RANGES         { \\\n");
+    for ( i=0; i<num; i++ )
+    {
+	r = &fnt->chars->ranges[i];
+	fprintf(output,"    {0x%04X,0x%04X,%d}%s \\\n",r->first,charset_used_last(fnt->chars,i),r->index,
+		(i<num-1)?",":"");
+    }
+    fprintf(output,"}\n");
+}
+
+/* A proportional renderer stores the ink box of each glyph. The table of the
+ * boxes is written as initializer too:
+ *
+ *  ,--------------------------
+ *  |static const struct { FONT_OFFSET_TYPE offset; uint8_t width, height; int8_t x, y; uint8_t advance; } my_glyphs[FONT_NUM_GLYPHS+1] = FONT_GLYPHS;
+ *  `--------------------------
+ *
+ * With FONT_GLYPH_INDEX, the table has FONT_NUM_UNIQUE+1 boxes. The offset
+ * of the last box is the end of the bitmaps.
+ *
+ * The bitmap of a box starts at offset with height rows of (width+7)/8 bytes.
+ * With FONT_PACKED the rows are packed, so row y starts at bit y*width. It is
+ * drawn at the pen position + x and the top of the line + y. After that the
+ * pen is moved by advance. If the glyphs are compressed, offset is the start
+ * of the compressed box and the next offset its end.
+ */
+static bool write_glyph_table ( t_font_definition *fnt )
+{
+    const t_glyph_box *b;
+    int size;
+    int idx;
+
+    for ( idx=0; idx<fnt->num_glyphs; idx++ )
+    {
+	b = &fnt->boxes[idx];
+	if ( b->width>255 || b->height>255 || b->advance<0 || b->advance>255 ||
+	     b->x<-128 || b->x>127 || b->y<-128 || b->y>127 )
+	{
+	    fprintf(stderr,"[%s] error: glyph #%d doesn't fit into the glyph table\n",MODULE_NAME,
+		    charset_code(fnt->chars,fnt->glyph_chars[idx]));
+	    return false;
+	}
+    }
+
+    fprintf(output,"#define FONT_PROPORTIONAL   1\n");
+    size = fnt->compressed ? fnt->compressed_size : fnt->buffer_size;
+    fprintf(output,"#define FONT_OFFSET_TYPE    %s\n",(size>0xFFFF)?"uint32_t":"uint16_t");
+    fprintf(output,"#define FONT_GLYPHS         { \\\n");
+    for ( idx=0; idx<fnt->num_glyphs; idx++ )
+    {
+	b = &fnt->boxes[idx];
+	fprintf(output,"    {%d,%d,%d,%d,%d,%d}%s \\\n",
+		fnt->compressed ? fnt->compressed_offsets[idx] : b->offset,
+		b->width,b->height,b->x,b->y,b->advance,
+		(idx<fnt->num_glyphs-1)?",":"");
+    }
+    fprintf(output,"}\n");
+    return true;
+}
+
+
+/* With --dedup, equal glyphs are stored only once. The stored glyph of each
+ * character is written as initializer:
+ *
+ *  ,--------------------------
+ *  |static const FONT_INDEX_TYPE my_index[FONT_NUM_GLYPHS] = FONT_GLYPH_INDEX;
+ *  `--------------------------
+ *
+ * The matrix of the glyph i starts at my_index[i]*FONT_MATRIX_SIZE. The
+ * boxes and the offsets of compressed glyphs are indexed by my_index[i] too.
+ */
+static void write_index_table ( t_font_definition *fnt )
+{
+    int idx;
+
+    fprintf(output,"#define FONT_NUM_UNIQUE     %d\n",fnt->num_glyphs-1);
+    fprintf(output,"#define FONT_INDEX_TYPE     %s\n",(fnt->num_glyphs>0x100)?"uint16_t":"uint8_t");
+    fprintf(output,"#define FONT_GLYPH_INDEX    { \\\n    ");
+    for ( idx=0; idx<fnt->num-1; idx++ )
+    {
+	fprintf(output,"%d%s",fnt->glyph_map[idx],(idx<fnt->num-2)?",":"");
+	if ( idx%16==15 && idx<fnt->num-2 )
+	    fprintf(output," \\\n    ");
+    }
+    fprintf(output," \\\n}\n");
+}
 
 static bool create ( t_font_definition *fnt )
 {
     int offs;			// offset info buffer of matrix data
     int mpitch;			// number of bytes per matrix row
-    uint8_t mbit;		// bitmask for matrix
-    int mbyte;			// byte within matrix row
-    int mx, my;			// pixel coordinates inside the output matrix
+    int baseline;		// row of the baseline
+    int my;			// row inside the output matrix
     int idx;			// index into gmatrices[]
     int i;
 
@@ -313,17 +542,33 @@ static bool create ( t_font_definition *fnt )
     }
     if ( is_verbose() )
 	fprintf(stderr,"[%s] create: called\n",MODULE_NAME);
+    if ( fnt->compressed )
+	return create_compressed(fnt);
+    if ( fnt->boxes )
+	return create_boxes(fnt);
 
     mpitch = fnt->matrix_pitch;
+    if ( !mpitch )
+    {
+	for ( idx=0; idx<(fnt->num_glyphs-1); idx++ )
+	{
+	    write_glyph_head(fnt,idx);
+	    offs = (fnt->matrix_size)*idx;
+	    write_bytes(fnt->buffer+offs,fnt->matrix_size,idx==fnt->num_glyphs-2);
+	    write_art(fnt,fnt->buffer+offs,fnt->matrix_width,fnt->matrix_height,fnt->matrix_stride,0);
+	}
+	return write_end();
+    }
 
     // not for raw array data
     // fprintf(output,"static uint8 __font_data[FONT_BUFFER_SIZE] = {\n");
 
     /* Walk through the generated character definitions
      */
-    for ( idx=0; idx<(fnt->num-1); idx++ )
+    baseline = fnt->metrics->matrix.height + fnt->metrics->baseline - 1;
+    for ( idx=0; idx<(fnt->num_glyphs-1); idx++ )
     {
-	fprintf(output,"// ----- #%d ------------------ \n",fnt->first+idx);
+	write_glyph_head(fnt,idx);
 	/* And dump the matrix of each character. The baseline is marked too.
 	 */
 	for ( my=0; my<(fnt->matrix_height); my++ )
@@ -331,41 +576,296 @@ static bool create ( t_font_definition *fnt )
 	    offs = (fnt->matrix_size)*idx + mpitch*my;
 	    for ( i=0; i<mpitch; i++ )
 	    {
-		if ( (i==mpitch-1) && (my==fnt->matrix_height-1) && (idx==fnt->num-2) )
-		    fprintf(output,"0x%2.2X",fnt->buffer[offs+i]);	// the last byte...
-		else
-		    fprintf(output,"0x%2.2X,",fnt->buffer[offs+i]);
-	    }
-	    fprintf(output,"     // ");
-	    for ( mx=0; mx<(fnt->matrix_width); mx++ )
-	    {
-		offs = (fnt->matrix_size) * idx;
-		mbyte = mx / 8;
-		mbit = 0x80 >> (mx&7);
-		offs += (mpitch*(my)+mbyte);
-		if ( fnt->buffer[offs]&mbit )
-		{
-		    // most important part... a bit is set!
-		    fprintf(output,"*");
-		}
-		else
-		    fprintf(output,".");
+		// no comma after the last byte...
+		out_hex(fnt->buffer[offs+i],
+			!((i==mpitch-1) && (my==fnt->matrix_height-1) && (idx==fnt->num_glyphs-2)));
 	    }
-	    if ( my == (fnt->metrics->matrix.height + fnt->metrics->baseline -1) )
-	    {
-		fprintf(output,"  __");
-	    }
-	    fprintf(output,"\n");
+	    out_text("     // ");
+	    out_art(fnt->buffer+offs,0,fnt->matrix_width);
+	    out_text( (my==baseline) ? "  __\n" : "\n" );
 	}
     }
 
     // fprintf(output,"};\n");
-    fprintf(output,"\n\n\n// ==================== end of file ====================\n");
+    return write_end();
+}
+
+/* Dump the bitmaps of the ink boxes of a proportional font. The baseline is
+ * marked like with the matrices.
+ */
+static bool create_boxes ( t_font_definition *fnt )
+{
+    const t_glyph_box *box;
+    int offs;			// offset info buffer of the box row
+    int baseline;		// row of the baseline
+    int my;			// row inside the box
+    int idx;			// index into the boxes
+    int i;
+
+    baseline = fnt->metrics->matrix.height + fnt->metrics->baseline - 1;
+    for ( idx=0; idx<(fnt->num_glyphs-1); idx++ )
+    {
+	box = &fnt->boxes[idx];
+	write_glyph_head(fnt,idx);
+	if ( !box->pitch )
+	{
+	    write_bytes(fnt->buffer+box->offset,box[1].offset-box->offset,box[1].offset==fnt->buffer_size);
+	    write_art(fnt,fnt->buffer+box->offset,box->width,box->height,box->stride,box->y);
+	    continue;
+	}
+	for ( my=0; my<(box->height); my++ )
+	{
+	    offs = box->offset + (box->pitch)*my;
+	    for ( i=0; i<(box->pitch); i++ )
+		out_hex(fnt->buffer[offs+i],offs+i != fnt->buffer_size-1);
+	    out_text("     // ");
+	    out_art(fnt->buffer+offs,0,box->width);
+	    out_text( (box->y+my==baseline) ? "  __\n" : "\n" );
+	}
+    }
+
+    return write_end();
+}
+
+/* Dump the compressed glyphs. The bitmap of each glyph is drawn below its
+ * bytes.
+ */
+static bool create_compressed ( t_font_definition *fnt )
+{
+    const t_glyph_box *box;
+    int offs, n;		// compressed bytes of the glyph
+    int last;			// end of the written data
+    int idx;			// index into the glyphs
+
+    last = fnt->compressed_offsets[fnt->num_glyphs-1];
+    for ( idx=0; idx<(fnt->num_glyphs-1); idx++ )
+    {
+	offs = fnt->compressed_offsets[idx];
+	n = fnt->compressed_offsets[idx+1] - offs;
+	write_glyph_head(fnt,idx);
+	write_bytes(fnt->compressed+offs,n,offs+n==last);
+	if ( fnt->boxes )
+	{
+	    box = &fnt->boxes[idx];
+	    write_art(fnt,fnt->buffer+box->offset,box->width,box->height,box->stride,box->y);
+	}
+	else
+	    write_art(fnt,fnt->buffer+(fnt->matrix_size)*idx,fnt->matrix_width,fnt->matrix_height,
+		      fnt->matrix_stride,0);
+    }
+
+    return write_end();
+}
+
+/* The compressed glyphs need their offsets and a decoder. Like the other
+ * tables, the offsets are written as initializer:
+ *
+ *  ,--------------------------
+ *  |static const FONT_OFFSET_TYPE my_offsets[FONT_NUM_GLYPHS+1] = FONT_OFFSETS;
+ *  `--------------------------
+ *
+ * With FONT_GLYPH_INDEX, there are FONT_NUM_UNIQUE+1 offsets. A proportional
+ * font has the offsets in FONT_GLYPHS. The reference decoder is a static
+ * function of the header, so it can be used without any library.
+ */
+static void write_decoder ( t_font_definition *fnt )
+{
+    int idx;
+
+    fprintf(output,"#define FONT_COMPRESSED     1\n");
+    if ( !fnt->boxes )
+    {
+	fprintf(output,"#define FONT_OFFSET_TYPE    %s\n",(fnt->compressed_size>0xFFFF)?"uint32_t":"uint16_t");
+	fprintf(output,"#define FONT_OFFSETS        { \\\n    ");
+	for ( idx=0; idx<fnt->num_glyphs; idx++ )
+	{
+	    fprintf(output,"%d%s",fnt->compressed_offsets[idx],(idx<fnt->num_glyphs-1)?",":"");
+	    if ( idx%16==15 && idx<fnt->num_glyphs-1 )
+		fprintf(output," \\\n    ");
+	}
+	fprintf(output," \\\n}\n");
+    }
+
+    fprintf(output,"\n#ifndef FONT_RLE_DECODER\n");
+    fprintf(output,"#define FONT_RLE_DECODER 1\n");
+    fprintf(output,"/* Decode the n bytes of the compressed glyph src into the size bytes of dst.\n");
+    fprintf(output," * The glyph i starts at offset[i], n is offset[i+1]-offset[i]. size is\n");
+    fprintf(output," * the size of the uncompressed glyph (FONT_MATRIX_SIZE or the size of the\n");
+    fprintf(output," * box). Codes: 0x00..0x7F copy code+1 bytes, 0x80..0xBF write (code&0x3F)+1\n");
+    fprintf(output," * zeros, 0xC0..0xFF repeat the next byte (code&0x3F)+2 times. The rest\n");
+    fprintf(output," * of dst is filled with zeros.\n");
+    fprintf(output," */\n");
+    fprintf(output,"static inline void font_decode_glyph ( uint8_t *dst, unsigned size, const uint8_t *src, unsigned n )\n");
+    fprintf(output,"{\n");
+    fprintf(output,"    const uint8_t *end = src + n;\n");
+    fprintf(output,"    uint8_t *stop = dst + size;\n");
+    fprintf(output,"    unsigned k;\n");
+    fprintf(output,"    uint8_t c;\n\n");
+    fprintf(output,"    while ( src < end )\n");
+    fprintf(output,"    {\n");
+    fprintf(output,"        c = *src++;\n");
+    fprintf(output,"        if ( c < 0x80 )\n");
+    fprintf(output,"            for ( k=c+1; k; k-- )\n");
+    fprintf(output,"                *dst++ = *src++;\n");
+    fprintf(output,"        else if ( c < 0xC0 )\n");
+    fprintf(output,"            for ( k=(c&0x3F)+1; k; k-- )\n");
+    fprintf(output,"                *dst++ = 0;\n");
+    fprintf(output,"        else\n");
+    fprintf(output,"        {\n");
+    fprintf(output,"            for ( k=(c&0x3F)+2; k; k-- )\n");
+    fprintf(output,"                *dst++ = *src;\n");
+    fprintf(output,"            src++;\n");
+    fprintf(output,"        }\n");
+    fprintf(output,"    }\n");
+    fprintf(output,"    while ( dst < stop )\n");
+    fprintf(output,"        *dst++ = 0;\n");
+    fprintf(output,"}\n");
+    fprintf(output,"#endif // FONT_RLE_DECODER\n");
+}
+
+/* The comment line in front of the stored glyph \c idx.
+ */
+static void write_glyph_head ( t_font_definition *fnt, int idx )
+{
+    out_reserve(OUT_RESERVE);
+    out_len += snprintf(out_buffer+out_len,OUT_RESERVE,"// ----- #%d ------------------ \n",
+			charset_code(fnt->chars,fnt->glyph_chars[idx]));
+}
+
+/* Dump the \c n bytes of \c data, 16 bytes per line. If \c last is set, these
+ * are the last bytes of the file, so the last one has no comma.
+ */
+static void write_bytes ( const uint8_t *data, int n, bool last )
+{
+    int i;
+
+    for ( i=0; i<n; i++ )
+    {
+	out_hex(data[i],!(last && i==n-1));	// the last byte...
+	if ( (i&15)==15 || i==n-1 )
+	    out_text("\n");
+    }
+}
+
+/* Draw the \c height rows of \c width pixels of \c bitmap as comments. The
+ * rows follow each other after \c stride bits. \c top is the row of the
+ * matrix which is the first row of the bitmap, so the baseline can be marked.
+ */
+static void write_art ( t_font_definition *fnt, const uint8_t *bitmap, int width, int height, int stride, int top )
+{
+    int baseline;		// row of the baseline
+    int my;			// row inside the bitmap
+
+    baseline = fnt->metrics->matrix.height + fnt->metrics->baseline - 1;
+    for ( my=0; my<height; my++ )
+    {
+	out_text("// ");
+	out_art(bitmap,my*stride,width);
+	out_text( (top+my==baseline) ? "  __\n" : "\n" );
+    }
+}
+
+/* Finish the data file and write the rest of the buffer.
+ */
+static bool write_end ( void )
+{
+    out_text("\n\n\n// ==================== end of file ====================\n");
+    if ( !out_flush() || out_error )
+    {
+	fprintf(stderr,"[%s] error: create: unable to write '%s'\n",MODULE_NAME,output_file);
+	return false;
+    }
+    complete = true;
     return true;
 }
 
+/* Make room for \c n more bytes in the buffer.
+ */
+static void out_reserve ( int n )
+{
+    if ( out_len+n > OUT_BUFFER_SIZE )
+	out_flush();
+}
+
+static bool out_flush ( void )
+{
+    if ( out_len && fwrite(out_buffer,1,out_len,output)!=(size_t)out_len )
+	out_error = true;
+    out_len = 0;
+    return !out_error;
+}
+
+static void out_text ( const char *text )
+{
+    int n = strlen(text);
+
+    out_reserve(n);
+    memcpy(out_buffer+out_len,text,n);
+    out_len += n;
+}
+
+/* Append \c value as "0xXX" with an optional comma.
+ */
+static void out_hex ( uint8_t value, bool comma )
+{
+    static const char digits[] = "0123456789ABCDEF";
+    char *p;
+
+    out_reserve(5);
+    p = out_buffer + out_len;
+    p[0] = '0';
+    p[1] = 'x';
+    p[2] = digits[value>>4];
+    p[3] = digits[value&0x0F];
+    p[4] = ',';
+    out_len += comma ? 5 : 4;
+}
+
+/* Append the \c width pixels of \c bitmap starting at bit \c bit as '*' and
+ * '.'. Each group of 8 pixels is taken from art_table, even if it doesn't
+ * start with a new byte.
+ */
+static void out_art ( const uint8_t *bitmap, int bit, int width )
+{
+    const uint8_t *src;
+    int shift;
+    uint8_t b;
+    int mx;
+
+    if ( width > OUT_BUFFER_SIZE-out_len )
+	out_flush();
+
+    src = bitmap + bit/8;
+    shift = bit&7;
+    for ( mx=0; mx+8<=width; mx+=8, src++ )
+    {
+	b = shift ? (src[0]<<shift) | (src[1]>>(8-shift)) : src[0];
+	memcpy(out_buffer+out_len,art_table[b],8);
+	out_len += 8;
+    }
+    for ( ; mx<width; mx++ )
+    {
+	bit = shift + (mx&7);
+	out_buffer[out_len++] = (src[bit/8]&(0x80>>(bit&7))) ? '*' : '.';
+    }
+}
+
+static void init_art_table ( void )
+{
+    int value, i;
+
+    for ( value=0; value<256; value++ )
+    {
+	for ( i=0; i<8; i++ )
+	    art_table[value][i] = (value&(0x80>>i)) ? '*' : '.';
+    }
+    art_table_ready = true;
+}
+
 static bool done ( t_font_definition *fnt )
 {
+    bool result = true;
+
     if ( !fnt )
     {
 	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
@@ -375,10 +875,14 @@ static bool done ( t_font_definition *fnt )
 	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
     if ( output )
     {
-	fclose(output);
+	if ( !close_output(output,output_file,complete) )
+	{
+	    fprintf(stderr,"[%s] error: done: unable to write '%s'\n",MODULE_NAME,output_file);
+	    result = false;
+	}
 	output = NULL;
     }
-    return true;
+    return result;
 }
 
 
@@ -52,6 +52,8 @@
 //{{{
 
 const t_writer_plugin* writer_c_raw_creator ( void );
+bool c_raw_write_header ( t_font_definition *fnt, const char *filename );
+int c_raw_data_size ( const t_font_definition *fnt );
 
 //}}}
 
@@ -0,0 +1,572 @@
+/* -*- Mode: C -*-
+ * --------------------------------------------------------------------------
+ * Copyright  (c) fontgen contributors
+ * --------------------------------------------------------------------------
+ * PROJECT: FONT Generator
+ * MODULE.: writer-elf.c
+ * AUTHOR.: fontgen contributors
+ * CREATED: 17.10.2026 06:56:23 UTC
+ * --------------------------------------------------------------------------
+ * DESCRIPTION:
+ * This "writer" creates a relocatable ELF object file, which can be linked
+ * into the firmware directly. No C compiler has to run over the font data.
+ *
+ * The object has a single section with the font (default ".rodata.fonts",
+ * see --section). It holds the same image as the file of the bin writer (see
+ * writer-bin.c). The machine of the object is selected with --arch. All
+ * supported machines are little endian. The symbols start with the basename
+ * of the output file:
+ *
+ *  ,--------------------------
+ *  |extern const uint8_t my_font[];          // the image with its header
+ *  |extern const uint32_t my_font_ranges[];  // {first, last, index} of each range
+ *  |extern const uint16_t my_font_index[];   // with --dedup only
+ *  |extern const uint8_t my_font_glyphs[];   // boxes of a proportional font only
+ *  |extern const uint32_t my_font_offsets[]; // with --compress only
+ *  |extern const uint8_t my_font_data[];     // the glyph data
+ *  `--------------------------
+ *
+ * The metadata (matrix size, number of glyphs, flags...) is read from the
+ * header of the image.
+ *
+ * --------------------------------------------------------------------------
+ * COMPILER-FLAGS:
+ *
+ * --------------------------------------------------------------------------
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+#define __WRITER_ELF_C__
+#include "fontgen.h"
+#include "writer-bin.h"
+
+
+/*+=========================================================================+*/
+/*|                      CONSTANT AND MACRO DEFINITIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+#define MODULE_NAME "elf"
+
+#define IMAGE_OFFSET 64		// file offset of the image (behind the ELF header)
+#define NUM_SECTIONS 6		// null, font, .symtab, .strtab, .shstrtab, .note.GNU-stack
+#define MAX_SYMBOLS  8		// null, section and 6 parts of the image
+
+/* the few ELF values used here
+ */
+#define ET_REL        1
+#define SHT_PROGBITS  1
+#define SHT_SYMTAB    2
+#define SHT_STRTAB    3
+#define SHF_ALLOC     2
+#define STB_LOCAL     0
+#define STB_GLOBAL    1
+#define STT_OBJECT    1
+#define STT_SECTION   3
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  local macro declaration                        \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+
+#define ALIGN(n,a) (((n)+(a)-1)&~((a)-1))
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                          LOCAL TYPEDECLARATIONS                         |*/
+/*`========================================================================='*/
+//{{{
+
+static t_writer_plugin this_plugin;
+
+/* A supported target of --arch
+ */
+typedef struct tagELF_MACHINE
+{
+    const char *name;
+    int machine;		// e_machine
+    bool elf64;			// ELFCLASS64 instead of ELFCLASS32
+    uint32_t flags;		// e_flags
+} t_elf_machine;
+
+/* A symbol of the image
+ */
+typedef struct tagELF_SYMBOL
+{
+    const char *suffix;		// appended to the basename
+    uint32_t value;		// offset inside the section
+    uint32_t size;
+} t_elf_symbol;
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                            PUBLIC VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                             LOCAL VARIABLES                             |*/
+/*`========================================================================='*/
+//{{{
+
+static const t_elf_machine machines[] =
+{
+    {"arm", 40, false, 0x05000000},	// EABI version 5
+    {"aarch64", 183, true, 0},
+    {"riscv32", 243, false, 0},
+    {"riscv64", 243, true, 0},
+    {"i386", 3, false, 0},
+    {"x86_64", 62, true, 0},
+    {"xtensa", 94, false, 0},
+    {NULL, 0, false, 0}
+};
+
+static char symbol_name[MAXPATH+2] = {""};	// one more for a leading '_'
+static char output_file[MAXPATH+1] = {""};
+static FILE *output = NULL;
+static bool complete = false;		// create() has written all data
+static const t_elf_machine *target = NULL;
+
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                      PROTOTYPES OF LOCAL FUNCTIONS                      |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init ( t_font_definition *fnt, const char *filename );
+static bool create ( t_font_definition *fnt );
+static bool done ( t_font_definition *fnt );
+static bool uptodate ( t_font_definition *fnt, const char *filename );
+static void create_output_filename ( t_font_definition *fnt , const char *filename );
+static int collect_symbols ( const uint8_t *image, int size, t_elf_symbol *symbols );
+static void write_elf_header ( uint8_t *p, int shoff );
+static void write_section ( uint8_t *p, int name, int type, int flags, int offset, int size, int link, int info, int align, int entsize );
+static void write_symbol ( uint8_t *p, int name, int info, int shndx, uint32_t value, uint32_t size );
+static void put16 ( uint8_t *p, unsigned value );
+static void put32 ( uint8_t *p, uint32_t value );
+static void put_word ( uint8_t *p, uint32_t value );
+static uint32_t get32 ( const uint8_t *p );
+static uint64_t get64 ( const uint8_t *p );
+
+
+//}}}
+
+/*+=========================================================================+*/
+/*|                     IMPLEMENTATION OF THE FUNCTIONS                     |*/
+/*`========================================================================='*/
+//{{{
+
+const t_writer_plugin* writer_elf_creator ( void )
+{
+    if ( is_verbose() )
+    {
+	fprintf(stderr,"[%s] writer_elf_creator: create writer.\n",MODULE_NAME);
+    }
+    this_plugin.done = done;
+    this_plugin.create = create;
+    this_plugin.init = init;
+    this_plugin.uptodate = uptodate;
+    return &this_plugin;
+}
+
+//}}}
+
+/*             .-----------------------------------------------.             */
+/* ___________/  Group...                                       \___________ */
+/*            `-------------------------------------------------'            */
+//{{{
+//}}}
+
+/*+=========================================================================+*/
+/*|                    IMPLEMENTATION OF LOCAL FUNCTIONS                    |*/
+/*`========================================================================='*/
+//{{{
+
+static bool init ( t_font_definition *fnt, const char *filename )
+{
+    const char *arch;
+    int i;
+
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: init: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init: called\n",MODULE_NAME);
+
+    arch = (fnt->options && fnt->options->arch[0]) ? fnt->options->arch : DEFAULT_ARCH;
+    target = NULL;
+    for ( i=0; machines[i].name; i++ )
+    {
+	if ( strcmp(machines[i].name,arch)==0 )
+	    target = &machines[i];
+    }
+    if ( !target )
+    {
+	fprintf(stderr,"[%s] error: init: unknown architecture '%s'\n",MODULE_NAME,arch);
+	return false;
+    }
+
+    create_output_filename(fnt,filename);
+    complete = false;
+    output = open_output(output_file,"wb");
+    if ( !output )
+    {
+	fprintf(stderr,"[%s] error: init: unable to create output file '%s'\n",MODULE_NAME,output_file);
+	return false;
+    }
+    return true;
+}
+
+/* The basename is used for the symbols too. Like the defines of the c-raw
+ * writer, every character which can't be used in a C name is replaced by '_'.
+ */
+static void create_output_filename ( t_font_definition *fnt , const char *filename )
+{
+    const char *base;
+    char *p;
+
+    if ( filename[0] == '\0')
+    {
+	if ( is_verbose() )
+	    fprintf(stderr,"[%s] init: creating output filename...\n",MODULE_NAME);
+	snprintf(output_file,MAXPATH,"%s_%d_%dx%d.o",
+		 fnt->metrics->name,
+		 fnt->metrics->pt_size,
+		 fnt->metrics->matrix.width,fnt->metrics->matrix.height);
+    }
+    else
+    {
+	snprintf(output_file,MAXPATH,"%s.o",filename);
+    }
+    output_file[MAXPATH] = '\0';
+
+    // only the last part of the path without ".o"
+    base = strrchr(output_file,'/');
+    base = base ? base+1 : output_file;
+    p = symbol_name;
+    if ( *base>='0' && *base<='9' )
+	*p++ = '_';
+    strcpy(p,base);
+    symbol_name[strlen(symbol_name)-2] = '\0';
+    for ( ; *p; p++ )
+    {
+	if ( !((*p>='a' && *p<='z') || (*p>='A' && *p<='Z') || (*p>='0' && *p<='9')) )
+	    *p = '_';
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] init: use output filename '%s'\n",MODULE_NAME,output_file);
+}
+
+/* The image starts at a fixed offset, so its hash is found without reading
+ * the section headers. The section headers are the end of the file, so
+ * their offset tells if the file is complete.
+ */
+static bool uptodate ( t_font_definition *fnt, const char *filename )
+{
+    uint8_t head[IMAGE_OFFSET+BIN_HASH_OFFSET+8];
+    uint64_t end;
+    bool found = false;
+    FILE *f;
+
+    if ( !fnt || !filename || !fnt->metrics )
+    {
+	fprintf(stderr,"[%s] error: uptodate: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    create_output_filename(fnt,filename);
+    f = fopen(output_file,"rb");
+    if ( !f )
+	return false;
+    if ( fread(head,sizeof(head),1,f)==1 && fseek(f,0,SEEK_END)==0 &&
+	 memcmp(head,"\177ELF",4)==0 && memcmp(head+IMAGE_OFFSET,BIN_MAGIC,4)==0 )
+    {
+	if ( head[4]==2 )	// ELFCLASS64
+	    end = get64(head+40) + NUM_SECTIONS*64;
+	else
+	    end = get32(head+32) + NUM_SECTIONS*40;
+	found = (get64(head+IMAGE_OFFSET+BIN_HASH_OFFSET)==fnt->hash) && end==(uint64_t)ftell(f);
+    }
+    fclose(f);
+    return found;
+}
+
+/* The object is build in memory and written at once:
+ *
+ *   ELF header | image | .symtab | .strtab | .shstrtab | section headers
+ */
+static bool create ( t_font_definition *fnt )
+{
+    t_elf_symbol symbols[MAX_SYMBOLS];
+    const char *section;
+    char *strtab;		// names of the symbols
+    char *shstrtab;		// names of the sections
+    uint8_t *image;		// the image of the bin writer
+    uint8_t *obj;		// the object file
+    int num_symbols;
+    int symsize;		// size of an entry of .symtab
+    int shsize;			// size of a section header
+    int names[MAX_SYMBOLS];	// offsets of the symbol names in strtab
+    int len, strtab_len, shstrtab_len;
+    int image_size, size;
+    int off_symtab, off_strtab, off_shstrtab, off_sh;
+    int i;
+
+    if ( !fnt || !target )
+    {
+	fprintf(stderr,"[%s] error: create: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] create: called\n",MODULE_NAME);
+
+    image = bin_create_image(fnt,&image_size);
+    if ( !image )
+	return false;
+    num_symbols = collect_symbols(image,image_size,symbols);
+    section = (fnt->options && fnt->options->section[0]) ? fnt->options->section : DEFAULT_SECTION;
+
+    /* The string tables. The names of the sections are at fixed offsets
+     * behind the name of the font section.
+     */
+    len = strlen(symbol_name);
+    strtab = calloc(1 + num_symbols*(len+16),sizeof(char));
+    shstrtab = calloc(strlen(section) + 64,sizeof(char));
+    if ( !strtab || !shstrtab )
+    {
+	fprintf(stderr,"[%s] error: create: memory allocation failed\n",MODULE_NAME);
+	free(strtab);
+	free(shstrtab);
+	free(image);
+	return false;
+    }
+    strtab_len = 1;
+    for ( i=0; i<num_symbols; i++ )
+    {
+	names[i] = strtab_len;
+	strtab_len += sprintf(strtab+strtab_len,"%s%s",symbol_name,symbols[i].suffix) + 1;
+    }
+    len = strlen(section);
+    memcpy(shstrtab+1,section,len);
+    shstrtab_len = 1 + len + 1;
+    memcpy(shstrtab+shstrtab_len,".symtab\0.strtab\0.shstrtab\0.note.GNU-stack",42);
+    shstrtab_len += 42;
+
+    symsize = target->elf64 ? 24 : 16;
+    shsize = target->elf64 ? 64 : 40;
+    off_symtab = ALIGN(IMAGE_OFFSET+image_size,8);
+    off_strtab = off_symtab + (2+num_symbols)*symsize;
+    off_shstrtab = off_strtab + strtab_len;
+    off_sh = ALIGN(off_shstrtab+shstrtab_len,8);
+    size = off_sh + NUM_SECTIONS*shsize;
+
+    obj = calloc(size,sizeof(uint8_t));
+    if ( !obj )
+    {
+	fprintf(stderr,"[%s] error: create: memory allocation failed\n",MODULE_NAME);
+	free(strtab);
+	free(shstrtab);
+	free(image);
+	return false;
+    }
+    write_elf_header(obj,off_sh);
+    memcpy(obj+IMAGE_OFFSET,image,image_size);
+
+    // the null symbol, the section and the parts of the image
+    write_symbol(obj+off_symtab+symsize,0,(STB_LOCAL<<4)|STT_SECTION,1,0,0);
+    for ( i=0; i<num_symbols; i++ )
+	write_symbol(obj+off_symtab+(2+i)*symsize,names[i],(STB_GLOBAL<<4)|STT_OBJECT,1,
+		     symbols[i].value,symbols[i].size);
+    memcpy(obj+off_strtab,strtab,strtab_len);
+    memcpy(obj+off_shstrtab,shstrtab,shstrtab_len);
+
+    // the section headers, the first one is empty
+    len = 1 + strlen(section) + 1;
+    write_section(obj+off_sh+shsize,1,SHT_PROGBITS,SHF_ALLOC,IMAGE_OFFSET,image_size,0,0,4,0);
+    write_section(obj+off_sh+2*shsize,len,SHT_SYMTAB,0,off_symtab,(2+num_symbols)*symsize,3,2,
+		  target->elf64?8:4,symsize);
+    write_section(obj+off_sh+3*shsize,len+8,SHT_STRTAB,0,off_strtab,strtab_len,0,0,1,0);
+    write_section(obj+off_sh+4*shsize,len+16,SHT_STRTAB,0,off_shstrtab,shstrtab_len,0,0,1,0);
+    write_section(obj+off_sh+5*shsize,len+26,SHT_PROGBITS,0,off_shstrtab,0,0,0,1,0);
+
+    free(strtab);
+    free(shstrtab);
+    free(image);
+    if ( fwrite(obj,1,size,output)!=(size_t)size )
+    {
+	fprintf(stderr,"[%s] error: create: unable to write '%s'\n",MODULE_NAME,output_file);
+	free(obj);
+	return false;
+    }
+    free(obj);
+    complete = true;
+    return true;
+}
+
+/* Get the parts of the image from its header. The size of a part is the
+ * distance to the next one.
+ */
+static int collect_symbols ( const uint8_t *image, int size, t_elf_symbol *symbols )
+{
+    static const char *suffix[] = { "_ranges", "_index", "_glyphs", "_offsets", "_data" };
+    uint32_t parts[6];
+    uint32_t end;
+    int num = 0;
+    int i, k;
+
+    for ( i=0; i<6; i++ )
+	parts[i] = get32(image+BIN_PARTS_OFFSET+4*i);
+    symbols[num].suffix = "";
+    symbols[num].value = 0;
+    symbols[num++].size = size;
+    for ( i=0; i<5; i++ )
+    {
+	if ( !parts[i] )
+	    continue;
+	if ( i == 4 )
+	    end = parts[4] + parts[5];
+	else
+	{
+	    for ( k=i+1; !parts[k]; k++ )
+		;
+	    end = parts[k];
+	}
+	symbols[num].suffix = suffix[i];
+	symbols[num].value = parts[i];
+	symbols[num++].size = end - parts[i];
+    }
+    return num;
+}
+
+static void write_elf_header ( uint8_t *p, int shoff )
+{
+    memcpy(p,"\177ELF",4);
+    p[4] = target->elf64 ? 2 : 1;	// EI_CLASS
+    p[5] = 1;				// EI_DATA: little endian
+    p[6] = 1;				// EI_VERSION
+    put16(p+16,ET_REL);
+    put16(p+18,target->machine);
+    put32(p+20,1);
+    if ( target->elf64 )
+    {
+	put32(p+40,shoff);		// e_shoff (64 bit)
+	put32(p+48,target->flags);
+	put16(p+52,64);			// e_ehsize
+	put16(p+58,64);			// e_shentsize
+	put16(p+60,NUM_SECTIONS);
+	put16(p+62,4);			// e_shstrndx
+    }
+    else
+    {
+	put32(p+32,shoff);
+	put32(p+36,target->flags);
+	put16(p+40,52);
+	put16(p+46,40);
+	put16(p+48,NUM_SECTIONS);
+	put16(p+50,4);
+    }
+}
+
+static void write_section ( uint8_t *p, int name, int type, int flags, int offset, int size, int link, int info, int align, int entsize )
+{
+    int w = target->elf64 ? 8 : 4;	// size of the address fields
+
+    put32(p,name);
+    put32(p+4,type);
+    put_word(p+8,flags);
+    put_word(p+8+2*w,offset);		// sh_addr is 0
+    put_word(p+8+3*w,size);
+    put32(p+8+4*w,link);
+    put32(p+12+4*w,info);
+    put_word(p+16+4*w,align);
+    put_word(p+16+5*w,entsize);
+}
+
+static void write_symbol ( uint8_t *p, int name, int info, int shndx, uint32_t value, uint32_t size )
+{
+    put32(p,name);
+    if ( target->elf64 )
+    {
+	p[4] = info;
+	put16(p+6,shndx);
+	put_word(p+8,value);
+	put_word(p+16,size);
+    }
+    else
+    {
+	put32(p+4,value);
+	put32(p+8,size);
+	p[12] = info;
+	put16(p+14,shndx);
+    }
+}
+
+static bool done ( t_font_definition *fnt )
+{
+    bool result = true;
+
+    if ( !fnt )
+    {
+	fprintf(stderr,"[%s] error: done: illegal parameters\n",MODULE_NAME);
+	return false;
+    }
+    if ( is_verbose() )
+	fprintf(stderr,"[%s] done: called\n",MODULE_NAME);
+    if ( output )
+    {
+	if ( !close_output(output,output_file,complete) )
+	{
+	    fprintf(stderr,"[%s] error: done: unable to write '%s'\n",MODULE_NAME,output_file);
+	    result = false;
+	}
+	output = NULL;
+    }
+    return result;
+}
+
+static void put16 ( uint8_t *p, unsigned value )
+{
+    p[0] = value & 0xFF;
+    p[1] = (value>>8) & 0xFF;
+}
+
+static void put32 ( uint8_t *p, uint32_t value )
+{
+    put16(p,value & 0xFFFF);
+    put16(p+2,value>>16);
+}
+
+/* An address or size field. The upper half of a 64 bit field stays 0.
+ */
+static void put_word ( uint8_t *p, uint32_t value )
+{
+    put32(p,value);
+}
+
+static uint32_t get32 ( const uint8_t *p )
+{
+    return p[0] | (p[1]<<8) | (p[2]<<16) | ((uint32_t)p[3]<<24);
+}
+
+static uint64_t get64 ( const uint8_t *p )
+{
+    return get32(p) | ((uint64_t)get32(p+4)<<32);
+}
+
+
+//}}}
+
+/* ==[End of file]========================================================== */